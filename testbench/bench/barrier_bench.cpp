@@ -0,0 +1,76 @@
+/*
+ * Thread barrier benchmark: measures simulation steps/sec of the add_thread()
+ * rendezvous in sim_driver with 1, 2, 4 and 8 child threads, using a driver
+ * whose _update() does no simulation work, so only the barrier is timed.
+ * Each thread count is run with blocking-only waits (barrier_spin=0) and with
+ * the adaptive spin. barrier_spin=0 keeps everything else the driver does per
+ * step, so it is not the barrier before spinning was added: to compare with
+ * that, run the same null driver against the older sim_driver.hpp.
+ *
+ *   ./bin/barrier_bench steps=200000 [pin_threads=1]
+ */
+
+#include "sim_driver.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class null_driver : protected sim_driver<null_driver> {
+  friend sim_driver<null_driver>;
+  duration_t m_now{0};
+
+protected:
+  duration_t get_now() { return m_now; }
+  void start() {}
+  duration_t _update() {
+    m_now += duration_t(1);
+    return duration_t(1);
+  }
+
+public:
+  null_driver(std::vector<std::string> args, int n_threads, long steps,
+              double &steps_per_sec) {
+    for (auto &a : args) {
+      auto eq = a.find('=');
+      cmd_line_args[a.substr(0, eq)] = a.substr(eq + 1);
+    }
+    sim_timeout = duration_t(0);
+    for (int i = 0; i < n_threads; ++i) {
+      add_thread([this] {
+        while (true)
+          update();
+      });
+    }
+    auto start = std::chrono::steady_clock::now();
+    run(duration_t(steps));
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    steps_per_sec = steps / elapsed.count();
+  }
+  ~null_driver() { shutdown(); }
+};
+
+int main(int argc, char **argv) {
+  long steps = 200000;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    std::string a(argv[i]);
+    if (a.rfind("steps=", 0) == 0)
+      steps = std::stol(a.substr(6));
+    else
+      args.push_back(a);
+  }
+
+  printf("%u hardware threads\n", std::thread::hardware_concurrency());
+  printf("%8s %16s %16s\n", "threads", "no spin steps/s", "spin steps/s");
+  for (int n_threads : {1, 2, 4, 8}) {
+    double block, spin;
+    auto block_args = args;
+    block_args.push_back("barrier_spin=0");
+    null_driver(block_args, n_threads, steps, block);
+    null_driver(args, n_threads, steps, spin);
+    printf("%8d %16.0f %16.0f\n", n_threads, block, spin);
+  }
+  return 0;
+}
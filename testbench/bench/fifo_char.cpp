@@ -0,0 +1,258 @@
+#include "bfm.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <vector>
+
+// The fifo configuration is fixed when the model is built, so bench/
+// CMakeLists.txt builds this file once per configuration and sets these.
+#ifndef FIFO_CHAR_L2DEPTH
+#define FIFO_CHAR_L2DEPTH 3
+#endif
+#ifndef FIFO_CHAR_MODE
+#define FIFO_CHAR_MODE NORMAL
+#endif
+#define FIFO_CHAR_STR2(x) #x
+#define FIFO_CHAR_STR(x) FIFO_CHAR_STR2(x)
+
+#if defined(USE_XSIM)
+#include "xsim_driver.hpp"
+#ifndef FIFO_CHAR_DUT
+#define FIFO_CHAR_DUT dc_fifo_xsim
+#endif
+#include FIFO_CHAR_STR(FIFO_CHAR_DUT.hpp)
+using dut_type = FIFO_CHAR_DUT;
+using driver_t = xsim_driver<dut_type>;
+#else
+#include "Vdc_fifo.h"
+#include "verilator_driver.hpp"
+using dut_type = Vdc_fifo;
+using driver_t = verilator_driver<dut_type>;
+#endif
+
+using namespace std::chrono_literals;
+
+/*
+ * dc_fifo throughput and latency characterization.
+ *
+ * Sweeps the rd_clk/wr_clk period ratio, the offered write and read rates and
+ * the burstiness of both sides over one fifo configuration, and writes one
+ * CSV row per point:
+ *   throughput_mwps  words per us from the first write to the last read
+ *   wr_full_stall    fraction of cycles with a word waiting that the writer
+ *                    wanted to write but was held off by wr_full
+ *   rd_empty_stall   fraction of rd_clk cycles the reader wanted to read but
+ *                    found rd_empty
+ *   lat_*_ns         wr_clk edge accepting a word to the rd_clk edge after
+ *                    which it was available to the reader, see fifo_monitor
+ *   occ_*            words in the fifo, sampled every wr_clk cycle
+ *
+ * Arguments (key=value, lists are comma separated):
+ *   wr_period=10       wr_clk period in ns
+ *   ratios=0.5,1,2     rd_clk period / wr_clk period
+ *   wr_rates=0.5,1     offered write rate, words per wr_clk cycle
+ *   rd_rates=1         offered read rate, reads per rd_clk cycle
+ *   bursts=1,8         mean burst length of both sides, 1 = no bursts
+ *   length=10000       words per point, at least 1
+ *   seed=1             also seeds the BFMs
+ *   csv=file           append rows to file (header written if it is empty),
+ *                      default stdout
+ *   hist=file          append the occupancy and latency histograms as
+ *                      "l2depth,mode,point,kind,bin,count" rows
+ */
+
+static std::vector<double> parse_list(const std::string &s) {
+  std::vector<double> r;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    r.push_back(std::stod(item));
+  }
+  return r;
+}
+
+static FILE *open_csv(const std::string &path, const char *header) {
+  if (path == "") {
+    printf("%s\n", header);
+    return stdout;
+  }
+  FILE *f = fopen(path.c_str(), "a");
+  except_assert2(f, "can not open " + path);
+  fseek(f, 0, SEEK_END);
+  if (ftell(f) == 0)
+    fprintf(f, "%s\n", header);
+  return f;
+}
+
+class fifo_char : public driver_t {
+  using duration_t = ClockDriver::duration_t;
+  static constexpr fifo_latency LATENCY = fifo_latency::FIFO_CHAR_MODE;
+  /// Seeds rng and, derived from it, the BFMs' rate generators
+  uint32_t seed;
+  fifo_monitor<dut_type, uint16_t, LATENCY> monitor;
+  fifo_writer<dut_type, uint16_t> writer;
+  fifo_reader<dut_type, uint16_t, LATENCY> reader;
+  ClockDriver *wr_clock, *rd_clock;
+  std::mt19937 rng;
+  FILE *csv, *hist;
+  int n_points = 0;
+
+  struct point_t {
+    double wr_period_ns, ratio, wr_rate, rd_rate, burst;
+    int length;
+  };
+
+  void reset() {
+    monitor.set_reset(true);
+    dut->wr_rstn = 0;
+    dut->rd_rstn = 0;
+    run(200ns);
+    dut->wr_rstn = 1;
+    dut->rd_rstn = 1;
+    run(200ns);
+    monitor.set_reset(false);
+    // the reader may have taken junk while rd_empty was unreliable
+    reader.clear();
+  }
+
+  void run_point(const point_t &p) {
+    double rd_period_ns = p.wr_period_ns * p.ratio;
+    wr_clock->set_period(p.wr_period_ns * 1ns);
+    rd_clock->set_period(rd_period_ns * 1ns);
+    writer.set_rate(p.wr_rate);
+    writer.set_burst(p.burst);
+    reader.set_rate(p.rd_rate);
+    reader.set_burst(p.burst);
+    reset();
+
+    std::vector<uint16_t> data(p.length);
+    for (auto &v : data) {
+      v = rng();
+    }
+    // generous bound: every word waits for the slower side at its rate
+    double worst_ns = std::max(p.wr_period_ns / p.wr_rate,
+                               rd_period_ns / p.rd_rate) *
+                      p.length * 4;
+    set_sim_timeout(duration_t(int64_t(worst_ns * 1000)) + 100us);
+
+    monitor.clear_stats();
+    writer.clear_stats();
+    reader.clear_stats();
+    reader.reserve(p.length);
+    duration_t start = get_now();
+    writer.push(data);
+    while (!writer.idle() || monitor.outstanding() || !reader.idle()) {
+      run(rd_clock->get_period());
+    }
+    except_assert(reader.received() == data);
+
+    auto lat = monitor.latency();
+    std::sort(lat.begin(), lat.end());
+    double lat_sum = 0;
+    for (auto l : lat) {
+      lat_sum += l.count();
+    }
+    auto &occ = monitor.occupancy();
+    uint64_t occ_samples = 0;
+    double occ_sum = 0;
+    for (unsigned i = 0; i < occ.size(); ++i) {
+      occ_samples += occ[i];
+      occ_sum += double(i) * occ[i];
+    }
+    auto ns = [](duration_t d) { return d.count() / 1000.0; };
+    double elapsed_ns = ns(get_now() - start);
+
+    fprintf(csv,
+            "%d,%s,%g,%g,%g,%g,%g,%d,%.4f,%.4f,%.4f,%.1f,%.1f,%.1f,%.1f,%.1f,"
+            "%.2f,%zu\n",
+            FIFO_CHAR_L2DEPTH, FIFO_CHAR_STR(FIFO_CHAR_MODE), p.wr_period_ns,
+            rd_period_ns, p.wr_rate, p.rd_rate, p.burst, p.length,
+            p.length * 1000.0 / elapsed_ns,
+            writer.cycles() ? double(writer.stalls()) / writer.cycles() : 0.0,
+            reader.cycles() ? double(reader.stalls()) / reader.cycles() : 0.0,
+            ns(lat.front()), lat_sum / lat.size() / 1000.0,
+            ns(lat[lat.size() / 2]), ns(lat[lat.size() * 99 / 100]),
+            ns(lat.back()), occ_sum / occ_samples, occ.size() - 1);
+
+    if (hist) {
+      std::string point_id = std::to_string(FIFO_CHAR_L2DEPTH) + "," +
+                             FIFO_CHAR_STR(FIFO_CHAR_MODE) + "," +
+                             std::to_string(n_points);
+      for (unsigned i = 0; i < occ.size(); ++i) {
+        fprintf(hist, "%s,occupancy,%u,%llu\n", point_id.c_str(), i,
+                (unsigned long long)occ[i]);
+      }
+      // latency in whole rd_clk cycles
+      std::vector<uint64_t> lat_hist;
+      for (auto l : lat) {
+        size_t bin = l / rd_clock->get_period();
+        if (lat_hist.size() <= bin)
+          lat_hist.resize(bin + 1);
+        lat_hist[bin]++;
+      }
+      for (unsigned i = 0; i < lat_hist.size(); ++i) {
+        if (lat_hist[i]) {
+          fprintf(hist, "%s,latency_rd_cycles,%u,%llu\n", point_id.c_str(),
+                  i, (unsigned long long)lat_hist[i]);
+        }
+      }
+    }
+    n_points++;
+  }
+
+public:
+  fifo_char(int argc, char **argv)
+      : driver_t(argc, argv), seed(std::stoul(get_cmd_line_arg("seed", "1"))),
+        monitor(dut), writer(dut, seed * 2 + 1), reader(dut, seed * 2 + 2),
+        rng(seed) {
+    wr_clock = &add_clock(dut->wr_clk, 10ns);
+    rd_clock = &add_clock(dut->rd_clk, 10ns);
+    monitor.attach(*wr_clock, *rd_clock);
+    writer.attach(*wr_clock);
+    reader.attach(*rd_clock);
+
+    // the latency statistics need at least one word per point
+    int length = std::stoi(get_cmd_line_arg("length", "10000"));
+    except_assert2(length > 0, "length must be at least 1");
+
+    csv = open_csv(get_cmd_line_arg("csv"),
+                   "l2depth,mode,wr_period_ns,rd_period_ns,wr_rate,rd_rate,"
+                   "burst,words,throughput_mwps,wr_full_stall,rd_empty_stall,"
+                   "lat_min_ns,lat_mean_ns,lat_p50_ns,lat_p99_ns,lat_max_ns,"
+                   "occ_mean,occ_max");
+    hist = nullptr;
+    if (auto path = get_cmd_line_arg("hist"); path != "") {
+      hist = open_csv(path, "l2depth,mode,point,kind,bin,count");
+    }
+
+    double wr_period = std::stod(get_cmd_line_arg("wr_period", "10"));
+    for (double ratio : parse_list(get_cmd_line_arg("ratios", "0.5,1,2"))) {
+      for (double wr_rate : parse_list(get_cmd_line_arg("wr_rates", "0.5,1"))) {
+        for (double rd_rate : parse_list(get_cmd_line_arg("rd_rates", "1"))) {
+          for (double burst : parse_list(get_cmd_line_arg("bursts", "1,8"))) {
+            run_point({wr_period, ratio, wr_rate, rd_rate, burst, length});
+          }
+        }
+      }
+    }
+  }
+  ~fifo_char() {
+    if (csv != stdout)
+      fclose(csv);
+    if (hist)
+      fclose(hist);
+  }
+};
+
+int main(int argc, char **argv) {
+
+  try {
+    fifo_char bench(argc, argv);
+  } catch (std::exception &e) {
+    printf("Characterization Failed:\n\t%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Multi-lane benchmark: streams `length` random words through each of the
+ * dc_fifo_LANES lanes of Vdc_fifo_lanes in one simulation, then the same
+ * traffic (same seeds) through a plain dc_fifo in one simulation per lane,
+ * and reports the wall time of both. Each run includes building the model
+ * and the reset. The single-lane model, Vdc_fifo_single, is verilated with
+ * the same options as the lanes model.
+ *
+ *   ./bin/lanes_bench seed=1 length=10000
+ */
+
+#include "Vdc_fifo_lanes.h"
+#include "Vdc_fifo_single.h"
+#include "lanes.hpp"
+#include "verilator_driver.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <string>
+
+using namespace std::chrono_literals;
+
+/* the traffic of one lane, on lane `lane` of a lanes model or on a plain one */
+template <typename dut_t> class fifo_stream {
+  dut_t *dut;
+  int lane;
+  std::mt19937 rng;
+  std::deque<uint16_t> expected;
+  int to_write;
+
+  // port[lane] of a lanes model, the port itself otherwise
+  template <typename port_t> auto &at(port_t &port) {
+    if constexpr (requires { port[0]; })
+      return port[lane];
+    else
+      return port;
+  }
+
+public:
+  fifo_stream(int lane, uint32_t seed, dut_t *dut, int length)
+      : dut(dut), lane(lane), rng(seed), to_write(length) {
+    at(dut->wr_write) = 0;
+    at(dut->rd_read) = 0;
+  }
+
+  void on_wr_clock() {
+    at(dut->wr_write) = 0;
+    if (to_write && !at(dut->wr_full) && rng() % 2) {
+      uint16_t v = rng();
+      at(dut->wr_din) = v;
+      at(dut->wr_write) = 1;
+      expected.push_back(v);
+      to_write--;
+    }
+  }
+
+  void on_rd_clock() {
+    if (at(dut->rd_read)) {
+      except_assert(!expected.empty());
+      except_assert(at(dut->rd_dout) == expected.front());
+      expected.pop_front();
+    }
+    at(dut->rd_read) = !at(dut->rd_empty) && rng() % 2;
+  }
+
+  bool done() const { return to_write == 0 && expected.empty(); }
+};
+
+/* one simulation running n_lanes streams on dut_t, returns the wall time */
+template <typename dut_t> class stream_run : public verilator_driver<dut_t> {
+  using base_t = verilator_driver<dut_t>;
+  using base_t::add_clock;
+  using base_t::dut;
+  using base_t::get_cmd_line_arg;
+  using base_t::run;
+  using base_t::set_sim_timeout;
+  // referenced by the clock callbacks, so it lives as long as the clocks
+  lane_set<fifo_stream<dut_t>> lanes;
+
+  template <typename port_t> static void reset(port_t &port, uint8_t v) {
+    if constexpr (requires { port[0]; }) {
+      for (int i = 0; i < dc_fifo_LANES; ++i)
+        port[i] = v;
+    } else {
+      port = v;
+    }
+  }
+
+public:
+  stream_run(int argc, char **argv, int n_lanes, uint32_t seed)
+      : base_t(argc, argv),
+        lanes(n_lanes, seed, dut,
+              std::stoi(get_cmd_line_arg("length", "10000"))) {
+    set_sim_timeout(std::chrono::seconds(1000));
+
+    auto &wr_clockdriver = add_clock(dut->wr_clk, 10ns);
+    auto &rd_clockdriver = add_clock(dut->rd_clk, 11ns);
+
+    reset(dut->wr_rstn, 0);
+    reset(dut->rd_rstn, 0);
+    run(1us);
+    reset(dut->wr_rstn, 1);
+    reset(dut->rd_rstn, 1);
+    run(100ns);
+
+    lanes.add_callback(wr_clockdriver, &fifo_stream<dut_t>::on_wr_clock);
+    lanes.add_callback(rd_clockdriver, &fifo_stream<dut_t>::on_rd_clock);
+    while (!lanes.all_done()) {
+      run(1us);
+    }
+    lanes.check();
+  }
+};
+
+template <typename run_t> static double timed(run_t run) {
+  auto start = std::chrono::steady_clock::now();
+  run();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+int main(int argc, char **argv) {
+  try {
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+      std::string a(argv[i]);
+      if (a.rfind("seed=", 0) == 0)
+        seed = std::stoul(a.substr(5));
+    }
+    double lanes = timed([&] {
+      stream_run<Vdc_fifo_lanes>(argc, argv, dc_fifo_LANES, seed);
+    });
+    double separate = 0;
+    for (int i = 0; i < dc_fifo_LANES; ++i) {
+      separate += timed(
+          [&] { stream_run<Vdc_fifo_single>(argc, argv, 1, seed + i); });
+    }
+    printf("%d lanes in one model: %.3f s\n", dc_fifo_LANES, lanes);
+    printf("%d separate runs:      %.3f s\n", dc_fifo_LANES, separate);
+    printf("speedup: %.2fx\n", separate / lanes);
+  } catch (std::exception &e) {
+    printf("Benchmark Failed:\n\t%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
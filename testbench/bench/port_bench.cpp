@@ -0,0 +1,70 @@
+/*
+ * Port access benchmark: polls the dc_fifo status outputs `polls` times per
+ * simulation step while streaming writes, and reports steps/sec. With the
+ * stub XSI kernel, run with XSI_STUB_STATS=1 to also see the number of
+ * kernel calls.
+ *
+ *   ./bin/port_bench_xsim steps=200000 polls=8
+ */
+
+#if defined(USE_XSIM)
+#include "dc_fifo_xsim.hpp"
+#include "xsim_driver.hpp"
+using driver_t = xsim_driver<dc_fifo_xsim>;
+#else
+#include "Vdc_fifo.h"
+#include "verilator_driver.hpp"
+using driver_t = verilator_driver<Vdc_fifo>;
+#endif
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+using namespace std::chrono_literals;
+class port_bench : public driver_t {
+public:
+  port_bench(int argc, char **argv) : driver_t(argc, argv) {
+    long steps = std::stol(get_cmd_line_arg("steps", "200000"));
+    int polls = std::stoi(get_cmd_line_arg("polls", "8"));
+
+    add_clock(dut->wr_clk, 10ns);
+    add_clock(dut->rd_clk, 11ns);
+    set_sim_timeout(std::chrono::seconds(1000));
+
+    dut->wr_rstn = 0;
+    dut->rd_rstn = 0;
+    dut->wr_write = 0;
+    dut->rd_read = 0;
+    run(100ns);
+    dut->wr_rstn = 1;
+    dut->rd_rstn = 1;
+
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long s = 0; s < steps; ++s) {
+      for (int p = 0; p < polls; ++p) {
+        checksum += dut->wr_full + dut->rd_empty + dut->rd_dout +
+                    dut->wr_usedw + dut->rd_usedw;
+      }
+      dut->wr_write = !dut->wr_full;
+      dut->wr_din = uint16_t(s);
+      dut->rd_read = !dut->rd_empty;
+      update();
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    printf("%ld steps, %d polls/step: %.0f steps/sec (checksum %llu)\n", steps,
+           polls, steps / elapsed.count(), (unsigned long long)checksum);
+  }
+};
+
+int main(int argc, char **argv) {
+  try {
+    port_bench bench(argc, argv);
+  } catch (std::exception &e) {
+    printf("Benchmark Failed:\n\t%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
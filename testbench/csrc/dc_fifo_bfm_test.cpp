@@ -0,0 +1,103 @@
+#include "bfm.hpp"
+#include "job_server.hpp"
+#if defined(USE_XSIM)
+#include "dc_fifo_xsim.hpp"
+#include "xsim_driver.hpp"
+using dut_type = dc_fifo_xsim;
+using driver_t = xsim_driver<dut_type>;
+#else
+#include "Vdc_fifo.h"
+#include "verilator_driver.hpp"
+using dut_type = Vdc_fifo;
+using driver_t = verilator_driver<dut_type>;
+#endif
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+
+using namespace std::chrono_literals;
+
+/*
+ * dc_fifo test driven entirely by the transaction level BFMs in bfm.hpp.
+ *
+ * Built on run_jobs(), so it also runs as a warm server (server=PATH): the
+ * BFMs and the random stream belong to one job and are rebuilt for each.
+ */
+class dc_fifo_bfm_test : public driver_t {
+  ClockDriver *wr_clock, *rd_clock;
+
+  struct job_t {
+    fifo_monitor<dut_type, uint16_t> monitor;
+    fifo_writer<dut_type, uint16_t> writer;
+    fifo_reader<dut_type, uint16_t> reader;
+    std::mt19937 rng;
+
+    job_t(dut_type *dut, ClockDriver &wr_clock, ClockDriver &rd_clock,
+          uint32_t seed)
+        : monitor(dut), writer(dut, seed * 2 + 1), reader(dut, seed * 2 + 2),
+          rng(seed) {
+      // the monitor samples the edge before the active BFMs change the inputs
+      monitor.attach(wr_clock, rd_clock);
+      writer.attach(wr_clock);
+      reader.attach(rd_clock);
+    }
+  };
+
+  void test(job_t &j, double wr_rate, double rd_rate, int test_length) {
+    std::vector<uint16_t> write_data(test_length);
+    for (auto &v : write_data) {
+      v = j.rng();
+    }
+    j.writer.set_rate(wr_rate);
+    j.reader.set_rate(rd_rate);
+    j.reader.clear();
+    j.reader.reserve(test_length);
+
+    set_sim_timeout(10ms);
+    j.writer.push(write_data);
+    while (!j.writer.idle() || j.monitor.outstanding() || !j.reader.idle()) {
+      run(1us);
+    }
+
+    except_assert(j.reader.received() == write_data);
+  }
+
+public:
+  dc_fifo_bfm_test(int argc, char **argv) : driver_t(argc, argv) {
+    wr_clock = &add_clock(dut->wr_clk, 10ns);
+    rd_clock = &add_clock(dut->rd_clk, 11ns);
+    dut->wr_write = 0;
+    dut->rd_read = 0;
+
+    run_jobs(
+        [this] {
+          dut->wr_rstn = 0;
+          dut->rd_rstn = 0;
+          run(1us);
+          dut->wr_rstn = 1;
+          dut->rd_rstn = 1;
+          run(100ns);
+        },
+        [this] {
+          job_t j(dut, *wr_clock, *rd_clock,
+                  std::stoul(get_cmd_line_arg("seed", "1")));
+          test(j, 1, 1, 1000);
+          test(j, .9, .1, 1000);
+          test(j, .1, .9, 1000);
+          test(j, .5, .5, 1000);
+          except_assert(j.monitor.writes() == 4000);
+        });
+  }
+};
+
+int main(int argc, char **argv) {
+
+  try {
+    dc_fifo_bfm_test test(argc, argv);
+  } catch (std::exception &e) {
+    printf("Test Failed:\n\t%s\n", e.what());
+    return 1;
+  }
+  printf("Test Passed!\n");
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include "Vdc_fifo_lanes.h"
+#include "coverage.hpp"
+#include "lanes.hpp"
+#include "verilator_driver.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <random>
+
+using namespace std::chrono_literals;
+
+/* one randomized dc_fifo test, running on lane `lane` of Vdc_fifo_lanes */
+class fifo_lane {
+  Vdc_fifo_lanes *dut;
+  int lane;
+  std::mt19937 rng;
+  std::deque<uint16_t> expected;
+  int to_write;
+  double wr_prob, rd_prob;
+
+  bool chance(double p) {
+    return std::uniform_real_distribution<double>(0, 1)(rng) < p;
+  }
+
+public:
+  fifo_coverage<3> cov;
+
+  fifo_lane(int lane, uint32_t seed, Vdc_fifo_lanes *dut, int test_length)
+      : dut(dut), lane(lane), rng(seed), to_write(test_length) {
+    // each lane gets its own traffic mix
+    wr_prob = std::uniform_real_distribution<double>(.1, .9)(rng);
+    rd_prob = std::uniform_real_distribution<double>(.1, .9)(rng);
+    dut->wr_write[lane] = 0;
+    dut->rd_read[lane] = 0;
+  }
+
+  void on_wr_clock() {
+    cov.sample_wr(dut->wr_write[lane], dut->wr_full[lane],
+                  dut->wr_usedw[lane]);
+    dut->wr_write[lane] = 0;
+    if (to_write && !dut->wr_full[lane] && chance(wr_prob)) {
+      uint16_t v = rng();
+      dut->wr_din[lane] = v;
+      dut->wr_write[lane] = 1;
+      expected.push_back(v);
+      to_write--;
+    }
+  }
+
+  void on_rd_clock() {
+    cov.sample_rd(dut->rd_read[lane], dut->rd_empty[lane],
+                  dut->rd_usedw[lane]);
+    if (dut->rd_read[lane]) {
+      except_assert(!expected.empty());
+      uint16_t got = dut->rd_dout[lane];
+      except_assert2(got == expected.front(),
+                     "expected " + std::to_string(expected.front()) + " got " +
+                         std::to_string(got));
+      expected.pop_front();
+    }
+    dut->rd_read[lane] = !dut->rd_empty[lane] && chance(rd_prob);
+  }
+
+  bool done() const { return to_write == 0 && expected.empty(); }
+};
+
+class dc_fifo_lanes_test : public verilator_driver<Vdc_fifo_lanes> {
+  // referenced by the clock callbacks, so it lives as long as the clocks
+  lane_set<fifo_lane> lanes;
+
+public:
+  dc_fifo_lanes_test(int argc, char **argv)
+      : verilator_driver(argc, argv),
+        lanes(dc_fifo_LANES, std::stoul(get_cmd_line_arg("seed", "1")), dut,
+              std::stoi(get_cmd_line_arg("length", "1000"))) {
+    auto &wr_clockdriver = add_clock(dut->wr_clk, 10ns);
+    auto &rd_clockdriver = add_clock(dut->rd_clk, 11ns);
+
+    for (int i = 0; i < dc_fifo_LANES; ++i) {
+      dut->wr_rstn[i] = 0;
+      dut->rd_rstn[i] = 0;
+    }
+    run(1us);
+    for (int i = 0; i < dc_fifo_LANES; ++i) {
+      dut->wr_rstn[i] = 1;
+      dut->rd_rstn[i] = 1;
+    }
+    run(100ns);
+
+    lanes.add_callback(wr_clockdriver, &fifo_lane::on_wr_clock);
+    lanes.add_callback(rd_clockdriver, &fifo_lane::on_rd_clock);
+    while (!lanes.all_done()) {
+      run(1us);
+    }
+    lanes.check();
+
+    if (get_cmd_line_arg("coverage") == "1") {
+      fifo_coverage<3> cov;
+      for (unsigned i = 0; i < lanes.size(); ++i) {
+        cov.merge(lanes[i].cov);
+      }
+      cov.report();
+    }
+  }
+};
+
+int main(int argc, char **argv) {
+
+  try {
+    dc_fifo_lanes_test test(argc, argv);
+  } catch (std::exception &e) {
+    printf("Test Failed:\n\t%s\n", e.what());
+    return 1;
+  }
+  printf("Test Passed!\n");
+  return 0;
+}
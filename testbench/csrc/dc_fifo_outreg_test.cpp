@@ -86,6 +86,7 @@ public:
   }
 
   dc_fifo_test(int argc, char **argv) : verilator_driver(argc, argv) {
+    srand(std::stoul(get_cmd_line_arg("seed", "1")));
     add_clock(dut->wr_clk, 10ns);
     auto &rd_clockdriver = add_clock(dut->rd_clk, 11ns);
 
@@ -1,5 +1,7 @@
 
 
+#include "coverage.hpp"
+#include <algorithm>
 #if defined(USE_XSIM)
 #include "dc_fifo_xsim.hpp"
 #include "xsim_driver.hpp"
@@ -23,6 +25,14 @@ public:
   }
   std::vector<uint16_t> read_data;
   double read_prob;
+  fifo_coverage<3> cov;
+  int full_events = 0;
+#if !defined(USE_XSIM)
+  // true occupancy, w_wptr - r_rptr, sampled on every wr_clk edge
+  probe_ref<CData> sim_used = probe<CData>("TOP.dc_fifo.sim_used");
+  probe_buffer<probe_ref<CData>> used_log{sim_used, 1 << 16};
+  int drained_events = 0;
+#endif
   void on_read_clock(ClockDriver::edge_e) {
     if (dut->rd_read) {
       // if 2 clocks set the read byte,
@@ -55,6 +65,11 @@ public:
     do_reset();
     read_data.clear();
     int stalls = 0;
+    full_events = 0;
+#if !defined(USE_XSIM)
+    used_log.clear();
+    drained_events = 0;
+#endif
     dut->wr_write = 0;
     for (int i = 0; i < test_length; ++i) {
       while (1) {
@@ -75,11 +90,19 @@ public:
         }
       }
     }
-    // debug(stalls);
-    run(1us);
-    while (!dut->rd_empty) {
-      run(1us);
+    if (get_cmd_line_arg("stats") == "1") {
+      printf("test(%.2f, %.2f, %d): %d wr_full stalls, full %d times\n",
+             wr_prob, rd_prob, test_length, stalls, full_events);
     }
+    // a stall needs the fifo to have gone full
+    except_assert(stalls == 0 || full_events > 0);
+    run(1us);
+    run_until(watch_equals(dut->rd_empty, 1));
+#if !defined(USE_XSIM)
+    // every word was read back
+    except_assert(sim_used == 0);
+    except_assert(test_length == 0 || drained_events > 0);
+#endif
 
     except_assert(read_data.size() == write_data.size());
 
@@ -92,11 +115,24 @@ public:
   }
 
   dc_fifo_test(int argc, char **argv) : driver_t(argc, argv) {
-    add_clock(dut->wr_clk, 10ns);
+    srand(std::stoul(get_cmd_line_arg("seed", "1")));
+    auto &wr_clockdriver = add_clock(dut->wr_clk, 10ns);
     auto &rd_clockdriver = add_clock(dut->rd_clk, 11ns);
 
+    // coverage is sampled before on_read_clock() changes rd_read
+    wr_clockdriver.add_callback([&](ClockDriver::edge_e) {
+      cov.sample_wr(dut->wr_write, dut->wr_full, dut->wr_usedw);
+    });
+    rd_clockdriver.add_callback([&](ClockDriver::edge_e) {
+      cov.sample_rd(dut->rd_read, dut->rd_empty, dut->rd_usedw);
+    });
     rd_clockdriver.add_callback(
         [&](ClockDriver::edge_e e) { on_read_clock(e); });
+    add_watch(watch_rise(dut->wr_full), [&] { full_events++; });
+#if !defined(USE_XSIM)
+    used_log.attach(wr_clockdriver);
+    add_watch(watch_fall(sim_used), [&] { drained_events++; });
+#endif
 
     dut->rd_read = 0;
     dut->wr_write = 0;
@@ -110,11 +146,37 @@ public:
 
     tick_wr();
 
-    test(.9, .1, 10);
-    test(.1, .9, 10);
-
-    test(.9, .1, 1000);
-    test(.1, .9, 1000);
+    if (get_cmd_line_arg("cov_stop") == "1") {
+      // run random tests only until the coverage goals are met
+      int max_tests = std::stoi(get_cmd_line_arg("max_tests", "1000"));
+      int n_tests = 0;
+      while (!cov.goals_met()) {
+        except_assert2(n_tests++ < max_tests, "coverage goals not met");
+        set_sim_timeout(10ms);
+        test(.05 + .9 * rand() / RAND_MAX, .05 + .9 * rand() / RAND_MAX, 100);
+      }
+      printf("coverage goals met after %d tests\n", n_tests);
+    } else {
+      test(.9, .1, 10);
+      test(.1, .9, 10);
+
+      test(.9, .1, 1000);
+#if !defined(USE_XSIM)
+      // a slow reader leaves every slot in use
+      except_assert(*std::max_element(used_log.begin(), used_log.end()) == 7);
+#endif
+      test(.1, .9, 1000);
+    }
+    if (get_cmd_line_arg("coverage") == "1" ||
+        get_cmd_line_arg("cov_stop") == "1") {
+      cov.report();
+    }
+    if (auto path = get_cmd_line_arg("coverage_file"); path != "") {
+      FILE *f = fopen(path.c_str(), "w");
+      except_assert2(f, "can not open " + path);
+      cov.save(f);
+      fclose(f);
+    }
   }
 };
 
@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License                                                           //
+//                                                                                //
+// Copyright (c) 2024, MicroRidge Technology                                      //
+//                                                                                //
+// Redistribution and use in source and binary forms, with or without             //
+// modification, are permitted provided that the following conditions are met:    //
+//                                                                                //
+// 1. Redistributions of source code must retain the above copyright notice, this //
+//    list of conditions and the following disclaimer.                            //
+//                                                                                //
+// 2. Redistributions in binary form must reproduce the above copyright notice,   //
+//    this list of conditions and the following disclaimer in the documentation   //
+//    and/or other materials provided with the distribution.                      //
+//                                                                                //
+// 3. Neither the name of the copyright holder nor the names of its               //
+//    contributors may be used to endorse or promote products derived from        //
+//    this software without specific prior written permission.                    //
+//                                                                                //
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"    //
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE      //
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE //
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE   //
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL     //
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR     //
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER     //
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  //
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE  //
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.           //
+////////////////////////////////////////////////////////////////////////////////////
+
+`default_nettype none
+/**/
+`timescale 1ns / 1ns
+// dc_fifo with WIDTH bits of data. T is a type parameter, which can not be
+// set from the simulator command line, so the wide tests elaborate this
+// wrapper with -GWIDTH / -generic_top WIDTH instead.
+module dc_fifo_wide #(
+    parameter WIDTH = 256,
+    parameter L2DEPTH = 3
+) (
+    input wire wr_clk,
+    input wire wr_rstn,
+    input wire [WIDTH-1:0] wr_din,
+    input wire wr_write,
+    output logic wr_full,
+    output logic [L2DEPTH-1:0] wr_usedw,
+
+    input wire rd_clk,
+    input wire rd_rstn,
+    input wire rd_read,
+    output logic [WIDTH-1:0] rd_dout,
+    output logic rd_empty,
+    output logic [L2DEPTH-1:0] rd_usedw
+);
+
+  dc_fifo #(
+      .T(logic [WIDTH-1:0]),
+      .L2DEPTH(L2DEPTH)
+  ) fifo (
+      .*
+  );
+
+endmodule
+`default_nettype wire
@@ -1,4 +1,4 @@
-
+#include "coverage.hpp"
 #if defined(USE_XSIM)
 #include "dc_ram_xsim.hpp"
 #include "xsim_driver.hpp"
@@ -12,6 +12,9 @@ using driver_t = verilator_driver<Vdc_ram>;
 using namespace std::chrono_literals;
 class dc_ram_test : public driver_t {
   ClockDriver cd_a, cd_b;
+  ram_coverage<6> cov;
+  // the port reads or writes in the current cycle, for the coverage
+  bool en_a = false, en_b = false;
   void tick_a(int ticks = 1) {
     while (ticks--) {
       run_until_rising_edge(dut->clk_a);
@@ -22,14 +25,29 @@ class dc_ram_test : public driver_t {
       run_until_rising_edge(dut->clk_b);
     }
   }
+  /// one cycle that reads or writes on port a/b
+  void access_a() {
+    en_a = true;
+    tick_a();
+    en_a = false;
+  }
+  void access_b() {
+    en_b = true;
+    tick_b();
+    en_b = false;
+  }
 
 public:
   dc_ram_test(int argc, char **argv)
       : driver_t(argc, argv),
         cd_a(ClockDriver([&](uint8_t clk) { dut->clk_a = clk; }, 15ns)),
         cd_b(ClockDriver([&](uint8_t clk) { dut->clk_b = clk; }, 10ns)) {
-    add_clock(dut->clk_a, 15ns);
-    add_clock(dut->clk_b, 10ns);
+    add_clock(dut->clk_a, 15ns).add_callback([&](ClockDriver::edge_e) {
+      cov.sample_a(en_a, dut->we_a, dut->addr_a);
+    });
+    add_clock(dut->clk_b, 10ns).add_callback([&](ClockDriver::edge_e) {
+      cov.sample_b(en_b, dut->we_b, dut->addr_b);
+    });
     dut->we_a = 0;
     dut->we_b = 0;
     tick_a(10);
@@ -51,7 +69,7 @@ public:
       dut->we_a = 1;
       dut->data_a = ~i;
       dut->addr_a = i;
-      tick_a();
+      access_a();
       dut->we_a = 0;
       tick_a();
     }
@@ -60,7 +78,7 @@ public:
       dut->addr_a = i;
       uint8_t expected_val = ~i;
       except_assert(dut->q_a != expected_val);
-      tick_a();
+      access_a();
       except_assert(dut->q_a == expected_val);
     }
     dut->addr_b = 17;
@@ -70,7 +88,7 @@ public:
       dut->addr_b = i;
       uint8_t expected_val = ~i;
       except_assert(dut->q_b != expected_val);
-      tick_b();
+      access_b();
       except_assert(dut->q_b == expected_val);
     }
 
@@ -79,7 +97,7 @@ public:
       dut->we_b = 1;
       dut->data_b = ~i + 7;
       dut->addr_b = i;
-      tick_b();
+      access_b();
       dut->we_b = 0;
       tick_b();
     }
@@ -88,7 +106,7 @@ public:
       dut->addr_b = i;
       uint8_t expected_val = ~i + 7;
       except_assert(dut->q_b != expected_val);
-      tick_b();
+      access_b();
       except_assert(dut->q_b == expected_val);
     }
 
@@ -97,9 +115,12 @@ public:
       dut->addr_a = i;
       uint8_t expected_val = ~i + 7;
       except_assert(dut->q_a != expected_val);
-      tick_a();
+      access_a();
       except_assert(dut->q_a == expected_val);
     }
+    if (get_cmd_line_arg("coverage") == "1") {
+      cov.report();
+    }
   }
 };
 
@@ -0,0 +1,427 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef BFM_HPP
+#define BFM_HPP
+#include "port_view.hpp"
+#include "sim_driver.hpp"
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Transaction level bus functional models for the dc_fifo and dc_ram
+ * interfaces.
+ *
+ * Each BFM is bound to the dut's ports at compile time through a port map: a
+ * struct of static accessors returning a reference to the port, defaulting to
+ * the port names of rtl/dc_fifo.sv and rtl/dc_ram.sv. Verilator declares the
+ * toplevel ports as reference members, which rule out pointers to members.
+ * Ports are accessed as ports::name(dut), inlined, so the same BFM drives a
+ * verilated model (integer or VlWide references) and an xsim model
+ * (sim_port members) with no virtual calls. Data words go through
+ * port_put()/port_get(), so T can also be a wider transaction word, e.g.
+ * std::array<uint64_t, 8> for a 512 bit port, moved with one memcpy.
+ *
+ * Tests queue transactions in bulk and attach() the BFM to a clock; the BFM
+ * then drives and samples the interface from that clock's rising edge
+ * callback while the test just runs time.
+ */
+
+/// Random gap insertion shared by the active BFMs: a transaction is issued
+/// on a cycle with probability `rate`. With set_burst(n), n > 1, the cycles
+/// that issue come in bursts of n on average (a two state on/off chain with
+/// the same long run rate), instead of independently.
+class bfm_rate {
+  std::minstd_rand m_rng;
+  uint32_t m_threshold = ~uint32_t(0);
+  uint32_t m_on_to_off = 0, m_off_to_on = 0;
+  bool m_on = true;
+  double m_rate = 1, m_burst = 1;
+
+  static uint32_t to_threshold(double p) {
+    return p >= 1.0 ? ~uint32_t(0) : uint32_t(p * 4294967295.0);
+  }
+  bool chance(uint32_t threshold) {
+    if (threshold == ~uint32_t(0))
+      return true;
+    uint32_t r = uint32_t(m_rng() - m_rng.min()) * 2u;
+    return r < threshold;
+  }
+  void update() {
+    m_threshold = to_threshold(m_rate);
+    if (m_burst > 1 && m_rate < 1) {
+      // leave a burst with p = 1/n, enter one with p chosen so the chain
+      // spends `rate` of its cycles on
+      m_on_to_off = to_threshold(1 / m_burst);
+      m_off_to_on = to_threshold(m_rate / (m_burst * (1 - m_rate)));
+    } else {
+      m_on_to_off = 0;
+    }
+  }
+
+public:
+  explicit bfm_rate(uint32_t seed = 1) : m_rng(seed) {}
+  void set_rate(double rate) {
+    m_rate = rate;
+    update();
+  }
+  void set_burst(double mean_length) {
+    m_burst = mean_length;
+    update();
+  }
+  /// advance one cycle, true if this cycle issues
+  bool go() {
+    if (m_on_to_off == 0)
+      return chance(m_threshold);
+    m_on = m_on ? !chance(m_on_to_off) : chance(m_off_to_on);
+    return m_on;
+  }
+};
+
+template <typename dut_t> struct dc_fifo_wr_ports {
+  static auto &write(dut_t *d) { return d->wr_write; }
+  static auto &din(dut_t *d) { return d->wr_din; }
+  static auto &full(dut_t *d) { return d->wr_full; }
+};
+
+template <typename dut_t> struct dc_fifo_rd_ports {
+  static auto &read(dut_t *d) { return d->rd_read; }
+  static auto &dout(dut_t *d) { return d->rd_dout; }
+  static auto &empty(dut_t *d) { return d->rd_empty; }
+};
+
+/// Read latency of the dc_fifo configurations, in rd_clk edges from the edge
+/// that accepts a read to the edge after which rd_dout holds the data.
+enum class fifo_latency { FWFT = 0, NORMAL = 1, OUT_REG = 2 };
+
+/**
+ * \brief Drives queued words into the write side of a dc_fifo.
+ *
+ * A word is presented with wr_write only while wr_full is low, so every
+ * asserted wr_write is accepted by the next wr_clk edge.
+ **/
+template <typename dut_t, typename T, typename ports = dc_fifo_wr_ports<dut_t>>
+class fifo_writer {
+  dut_t *dut;
+  std::deque<T> m_queue;
+  bfm_rate m_rate;
+  uint64_t m_sent = 0;
+  uint64_t m_cycles = 0, m_stalls = 0;
+
+public:
+  fifo_writer(dut_t *dut, uint32_t seed = 1) : dut(dut), m_rate(seed) {
+    ports::write(dut) = 0;
+  }
+
+  void attach(ClockDriver &wr_clock) {
+    wr_clock.add_callback([this](ClockDriver::edge_e) { on_clock(); });
+  }
+  void set_rate(double rate) { m_rate.set_rate(rate); }
+  void set_burst(double mean_length) { m_rate.set_burst(mean_length); }
+
+  void push(const T &v) { m_queue.push_back(v); }
+  void push(std::span<const T> v) {
+    m_queue.insert(m_queue.end(), v.begin(), v.end());
+  }
+
+  /// no words queued and none in flight
+  bool idle() const { return m_queue.empty() && !ports::write(dut); }
+  uint64_t sent() const { return m_sent; }
+  /// cycles with a word queued, and how many of them wanted to write but
+  /// were held off by wr_full
+  uint64_t cycles() const { return m_cycles; }
+  uint64_t stalls() const { return m_stalls; }
+  void clear_stats() { m_cycles = m_stalls = 0; }
+
+  void on_clock() {
+    if (ports::write(dut)) {
+      // accepted by the edge that just happened
+      m_queue.pop_front();
+      m_sent++;
+    }
+    bool go = m_rate.go();
+    ports::write(dut) = 0;
+    if (m_queue.empty())
+      return;
+    m_cycles++;
+    if (go && ports::full(dut)) {
+      m_stalls++;
+    } else if (go) {
+      port_put(ports::din(dut), m_queue.front());
+      ports::write(dut) = 1;
+    }
+  }
+};
+
+/**
+ * \brief Reads words from the read side of a dc_fifo into received().
+ *
+ * rd_read is asserted only while rd_empty is low, so every asserted rd_read
+ * is accepted. LATENCY selects when rd_dout is sampled, see fifo_latency.
+ **/
+template <typename dut_t, typename T,
+          fifo_latency LATENCY = fifo_latency::NORMAL,
+          typename ports = dc_fifo_rd_ports<dut_t>>
+class fifo_reader {
+  static constexpr int L = int(LATENCY);
+  dut_t *dut;
+  bfm_rate m_rate;
+  uint32_t m_pipe = 0;
+  std::vector<T> m_received;
+  uint64_t m_cycles = 0, m_stalls = 0;
+
+public:
+  fifo_reader(dut_t *dut, uint32_t seed = 2) : dut(dut), m_rate(seed) {
+    ports::read(dut) = 0;
+  }
+
+  void attach(ClockDriver &rd_clock) {
+    rd_clock.add_callback([this](ClockDriver::edge_e) { on_clock(); });
+  }
+  void set_rate(double rate) { m_rate.set_rate(rate); }
+  void set_burst(double mean_length) { m_rate.set_burst(mean_length); }
+  void reserve(size_t n) { m_received.reserve(n); }
+
+  const std::vector<T> &received() const { return m_received; }
+  void clear() { m_received.clear(); }
+  /// no read waiting for its data
+  bool idle() const { return !ports::read(dut) && m_pipe == 0; }
+  /// cycles seen, and how many of them wanted to read but found rd_empty
+  uint64_t cycles() const { return m_cycles; }
+  uint64_t stalls() const { return m_stalls; }
+  void clear_stats() { m_cycles = m_stalls = 0; }
+
+  void on_clock() {
+    m_cycles++;
+    if constexpr (L > 0) {
+      m_pipe = (m_pipe << 1) | (ports::read(dut) ? 1 : 0);
+      if (m_pipe & (1u << (L - 1))) {
+        m_received.push_back(port_get<T>(ports::dout(dut)));
+      }
+      // keep only the reads still waiting for their data
+      m_pipe &= (1u << (L - 1)) - 1;
+    }
+    bool go = m_rate.go();
+    if (go && ports::empty(dut))
+      m_stalls++;
+    bool read = go && !ports::empty(dut);
+    if constexpr (L == 0) {
+      // first word fall through: the word being read is already on rd_dout
+      if (read)
+        m_received.push_back(port_get<T>(ports::dout(dut)));
+    }
+    ports::read(dut) = read ? 1 : 0;
+  }
+};
+
+/**
+ * \brief Passive scoreboard for a dc_fifo: records every word accepted on the
+ * write side and checks that the read side returns them in order.
+ *
+ * Attach to both clocks before any active BFM, so it samples wr_write/rd_read
+ * as they were at the edge. It also timestamps each word, so latency() holds
+ * the time from the wr_clk edge that accepted it to the rd_clk edge after
+ * which it was available to the reader (on rd_dout for FWFT, LATENCY edges
+ * after the read otherwise), and keeps a histogram of the words in flight,
+ * sampled on every wr_clk edge.
+ **/
+template <typename dut_t, typename T,
+          fifo_latency LATENCY = fifo_latency::NORMAL,
+          typename wr_ports = dc_fifo_wr_ports<dut_t>,
+          typename rd_ports = dc_fifo_rd_ports<dut_t>>
+class fifo_monitor {
+  using duration_t = ClockDriver::duration_t;
+  static constexpr int L = int(LATENCY);
+  dut_t *dut;
+  const ClockDriver *m_wr_clock = nullptr, *m_rd_clock = nullptr;
+  bool m_prev_full = false, m_prev_empty = true;
+  bool m_in_reset = false;
+  uint32_t m_pipe = 0;
+  T m_fwft_word{};
+  duration_t m_fwft_shown{0};
+  struct entry_t {
+    T data;
+    duration_t written;
+  };
+  std::deque<entry_t> m_expected;
+  uint64_t m_writes = 0, m_reads = 0;
+  std::vector<duration_t> m_latency;
+  std::vector<uint64_t> m_occupancy;
+
+  void check_read(const T &v, duration_t available) {
+    except_assert2(!m_expected.empty(), "read from an empty fifo");
+    except_assert2(v == m_expected.front().data,
+                   "read #" + std::to_string(m_reads) + " mismatch");
+    m_latency.push_back(available - m_expected.front().written);
+    m_expected.pop_front();
+    m_reads++;
+  }
+
+public:
+  fifo_monitor(dut_t *dut) : dut(dut) {}
+
+  void attach(ClockDriver &wr_clock, ClockDriver &rd_clock) {
+    m_wr_clock = &wr_clock;
+    m_rd_clock = &rd_clock;
+    wr_clock.add_callback([this](ClockDriver::edge_e) { on_wr_clock(); });
+    rd_clock.add_callback([this](ClockDriver::edge_e) { on_rd_clock(); });
+  }
+
+  uint64_t writes() const { return m_writes; }
+  uint64_t reads() const { return m_reads; }
+  /// words written but not read yet
+  size_t outstanding() const { return m_expected.size(); }
+  /// Ignore the interface while the dut is in reset and drop the words in
+  /// flight. rd_empty is not reliable during a reset: the pointer
+  /// synchronizers are not reset, so it can drop while the reset pointers
+  /// cross over.
+  void set_reset(bool in_reset) {
+    m_in_reset = in_reset;
+    m_expected.clear();
+    m_pipe = 0;
+  }
+
+  /// write to read latency of every word read since clear_stats()
+  const std::vector<duration_t> &latency() const { return m_latency; }
+  /// wr_clk cycles spent at each number of outstanding words
+  const std::vector<uint64_t> &occupancy() const { return m_occupancy; }
+  void clear_stats() {
+    m_latency.clear();
+    m_occupancy.clear();
+  }
+
+  void on_wr_clock() {
+    if (wr_ports::write(dut) && !m_prev_full && !m_in_reset) {
+      m_expected.push_back(
+          {port_get<T>(wr_ports::din(dut)), m_wr_clock->last_update()});
+      m_writes++;
+    }
+    m_prev_full = wr_ports::full(dut);
+    if (m_occupancy.size() <= m_expected.size())
+      m_occupancy.resize(m_expected.size() + 1);
+    m_occupancy[m_expected.size()]++;
+  }
+
+  void on_rd_clock() {
+    duration_t now = m_rd_clock->last_update();
+    bool accepted = rd_ports::read(dut) && !m_prev_empty && !m_in_reset;
+    if constexpr (L == 0) {
+      // the word consumed by this edge was on rd_dout before it, since the
+      // edge that read the previous word or ended rd_empty
+      if (accepted)
+        check_read(m_fwft_word, m_fwft_shown);
+      if (accepted || m_prev_empty)
+        m_fwft_shown = now;
+      m_fwft_word = port_get<T>(rd_ports::dout(dut));
+    } else {
+      m_pipe = ((m_pipe << 1) | (accepted ? 1 : 0)) & ((1u << L) - 1);
+      if (m_pipe & (1u << (L - 1)))
+        check_read(port_get<T>(rd_ports::dout(dut)), now);
+    }
+    m_prev_empty = rd_ports::empty(dut);
+  }
+};
+
+template <typename dut_t> struct dc_ram_a_ports {
+  static auto &we(dut_t *d) { return d->we_a; }
+  static auto &addr(dut_t *d) { return d->addr_a; }
+  static auto &data(dut_t *d) { return d->data_a; }
+  static auto &q(dut_t *d) { return d->q_a; }
+};
+
+template <typename dut_t> struct dc_ram_b_ports {
+  static auto &we(dut_t *d) { return d->we_b; }
+  static auto &addr(dut_t *d) { return d->addr_b; }
+  static auto &data(dut_t *d) { return d->data_b; }
+  static auto &q(dut_t *d) { return d->q_b; }
+};
+
+template <typename T> struct ram_transaction {
+  bool write;
+  uint32_t addr;
+  T data; ///< write data, or the read data once completed
+};
+
+/**
+ * \brief Issues queued reads and writes on one port of a dc_ram, one per
+ * clock, and collects the completed transactions (with read data filled in)
+ * in completed().
+ **/
+template <typename dut_t, typename T, typename ports>
+class ram_port_driver {
+  dut_t *dut;
+  std::deque<ram_transaction<T>> m_queue;
+  std::vector<ram_transaction<T>> m_completed;
+  bool m_in_flight = false;
+  bfm_rate m_rate;
+
+public:
+  ram_port_driver(dut_t *dut, uint32_t seed = 3) : dut(dut), m_rate(seed) {
+    ports::we(dut) = 0;
+  }
+
+  void attach(ClockDriver &clock) {
+    clock.add_callback([this](ClockDriver::edge_e) { on_clock(); });
+  }
+  void set_rate(double rate) { m_rate.set_rate(rate); }
+
+  void write(uint32_t addr, const T &data) {
+    m_queue.push_back({true, addr, data});
+  }
+  void read(uint32_t addr) { m_queue.push_back({false, addr, T{}}); }
+  void push(std::span<const ram_transaction<T>> t) {
+    m_queue.insert(m_queue.end(), t.begin(), t.end());
+  }
+
+  bool idle() const { return m_queue.empty() && !m_in_flight; }
+  const std::vector<ram_transaction<T>> &completed() const {
+    return m_completed;
+  }
+  void clear() { m_completed.clear(); }
+
+  void on_clock() {
+    if (m_in_flight) {
+      // q is registered at the edge that sampled the address
+      auto t = m_queue.front();
+      m_queue.pop_front();
+      if (!t.write)
+        t.data = port_get<T>(ports::q(dut));
+      m_completed.push_back(t);
+      m_in_flight = false;
+    }
+    ports::we(dut) = 0;
+    if (!m_queue.empty() && m_rate.go()) {
+      auto &t = m_queue.front();
+      ports::addr(dut) = t.addr;
+      if (t.write) {
+        port_put(ports::data(dut), t.data);
+        ports::we(dut) = 1;
+      }
+      m_in_flight = true;
+    }
+  }
+};
+
+#endif // BFM_HPP
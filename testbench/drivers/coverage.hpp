@@ -0,0 +1,276 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef COVERAGE_HPP
+#define COVERAGE_HPP
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Histogram of hit counts with a goal per bin. A plain counter is a
+ * cov_point with one bin.
+ *
+ * hit() is a single array increment and is not thread safe: give each thread
+ * its own collector and merge() them at the end of the run.
+ **/
+class cov_point {
+  std::string m_name;
+  std::vector<uint64_t> m_bins;
+  std::vector<uint64_t> m_goals;
+
+public:
+  cov_point(std::string name, size_t n_bins, uint64_t goal)
+      : m_name(name), m_bins(n_bins, 0), m_goals(n_bins, goal) {}
+
+  void hit(size_t bin) { ++m_bins[bin]; }
+  /// set the goal of one bin, 0 for bins that are only counted
+  void set_goal(size_t bin, uint64_t goal) { m_goals[bin] = goal; }
+
+  const std::string &name() const { return m_name; }
+  size_t size() const { return m_bins.size(); }
+  uint64_t count(size_t bin) const { return m_bins[bin]; }
+  uint64_t goal(size_t bin) const { return m_goals[bin]; }
+  bool bin_met(size_t bin) const { return m_bins[bin] >= m_goals[bin]; }
+
+  void merge(const cov_point &other) {
+    if (other.m_bins.size() != m_bins.size())
+      throw std::runtime_error("can not merge coverage point " + m_name);
+    for (size_t i = 0; i < m_bins.size(); ++i) {
+      m_bins[i] += other.m_bins[i];
+    }
+  }
+};
+
+/**
+ * \brief Named set of cov_points that are reported and merged together.
+ *
+ * Derived collectors declare their points as members and register them with
+ * add() in the constructor.
+ **/
+class cov_group {
+  std::string m_name;
+  std::vector<cov_point *> m_points;
+
+protected:
+  cov_group(std::string name) : m_name(name) {}
+  cov_group(const cov_group &) = delete;
+  cov_group &operator=(const cov_group &) = delete;
+  void add(cov_point &p) { m_points.push_back(&p); }
+
+public:
+  const std::string &name() const { return m_name; }
+
+  void merge(const cov_group &other) {
+    if (other.m_points.size() != m_points.size())
+      throw std::runtime_error("can not merge coverage group " + m_name);
+    for (size_t i = 0; i < m_points.size(); ++i) {
+      m_points[i]->merge(*other.m_points[i]);
+    }
+  }
+
+  /// number of bins with a goal, and how many of them are met
+  void goal_count(unsigned &total, unsigned &met) const {
+    total = met = 0;
+    for (auto p : m_points) {
+      for (size_t b = 0; b < p->size(); ++b) {
+        if (p->goal(b)) {
+          total++;
+          met += p->bin_met(b);
+        }
+      }
+    }
+  }
+  bool goals_met() const {
+    unsigned total, met;
+    goal_count(total, met);
+    return total == met;
+  }
+
+  /// human readable summary, listing the bins that missed their goal
+  void report(FILE *f = stdout) const {
+    unsigned total, met;
+    goal_count(total, met);
+    fprintf(f, "coverage %s: %u/%u goals met\n", m_name.c_str(), met, total);
+    for (auto p : m_points) {
+      uint64_t hits = 0;
+      std::string missing;
+      for (size_t b = 0; b < p->size(); ++b) {
+        hits += p->count(b);
+        if (!p->bin_met(b)) {
+          missing += " [" + std::to_string(b) +
+                     "]=" + std::to_string(p->count(b)) + "/" +
+                     std::to_string(p->goal(b));
+        }
+      }
+      fprintf(f, "  %-24s %10llu%s%s\n", p->name().c_str(),
+              (unsigned long long)hits, missing.empty() ? "" : "  missing:",
+              missing.c_str());
+    }
+  }
+
+  /// one "group point bin count goal" line per bin, for merging across runs
+  void save(FILE *f) const {
+    for (auto p : m_points) {
+      for (size_t b = 0; b < p->size(); ++b) {
+        fprintf(f, "%s %s %zu %llu %llu\n", m_name.c_str(), p->name().c_str(),
+                b, (unsigned long long)p->count(b),
+                (unsigned long long)p->goal(b));
+      }
+    }
+  }
+};
+
+/**
+ * \brief Functional coverage of a dc_fifo interface, sampled from the ports
+ * only.
+ *
+ * Call sample_wr() on every rising edge of wr_clk and sample_rd() on every
+ * rising edge of rd_clk, before the testbench changes wr_write/rd_read for
+ * the next cycle. The two sides may be sampled from different threads.
+ *
+ * A read and a write are concurrent when a write is accepted at a wr_clk edge
+ * and the latest rd_clk edge accepted a read, i.e. both pointers move within
+ * one read clock period.
+ **/
+template <int L2DEPTH> class fifo_coverage : public cov_group {
+  static constexpr unsigned DEPTH = 1 << L2DEPTH;
+
+  bool m_prev_full = false, m_prev_empty = false;
+  unsigned m_prev_wr_usedw = 0;
+  uint64_t m_writes = 0, m_reads = 0;
+  // the latest rd_clk edge accepted a read
+  std::atomic<bool> m_rd_accepted{false};
+
+public:
+  cov_point wr_occupancy{"wr_occupancy", DEPTH, 10};
+  cov_point rd_occupancy{"rd_occupancy", DEPTH, 10};
+  cov_point full_rise{"full_rise", 1, 10};
+  cov_point full_fall{"full_fall", 1, 10};
+  cov_point empty_rise{"empty_rise", 1, 10};
+  cov_point empty_fall{"empty_fall", 1, 10};
+  /// write/read pointer wrapped around, i.e. the cc_gray pointer rolled over
+  cov_point wr_wrap{"wr_ptr_wrap", 1, 2};
+  cov_point rd_wrap{"rd_ptr_wrap", 1, 2};
+  /// concurrent read and write, by write side occupancy
+  cov_point rd_wr_occupancy{"rd_wr_at_occupancy", DEPTH, 1};
+
+  fifo_coverage() : cov_group("dc_fifo") {
+    for (auto p : {&wr_occupancy, &rd_occupancy, &full_rise, &full_fall,
+                   &empty_rise, &empty_fall, &wr_wrap, &rd_wrap,
+                   &rd_wr_occupancy}) {
+      add(*p);
+    }
+    // nothing can be read at occupancy 0 and nothing written when full
+    rd_wr_occupancy.set_goal(0, 0);
+    rd_wr_occupancy.set_goal(DEPTH - 1, 0);
+  }
+
+  void sample_wr(bool write, bool full, unsigned usedw) {
+    wr_occupancy.hit(usedw);
+    if (full && !m_prev_full)
+      full_rise.hit(0);
+    if (!full && m_prev_full)
+      full_fall.hit(0);
+    if (write && !m_prev_full) {
+      if (++m_writes % DEPTH == 0)
+        wr_wrap.hit(0);
+      if (m_rd_accepted.load(std::memory_order_relaxed))
+        rd_wr_occupancy.hit(m_prev_wr_usedw);
+    }
+    m_prev_full = full;
+    m_prev_wr_usedw = usedw;
+  }
+
+  void sample_rd(bool read, bool empty, unsigned usedw) {
+    rd_occupancy.hit(usedw);
+    if (empty && !m_prev_empty)
+      empty_rise.hit(0);
+    if (!empty && m_prev_empty)
+      empty_fall.hit(0);
+    bool accepted = read && !m_prev_empty;
+    if (accepted && ++m_reads % DEPTH == 0)
+      rd_wrap.hit(0);
+    m_rd_accepted.store(accepted, std::memory_order_relaxed);
+    m_prev_empty = empty;
+  }
+};
+
+/**
+ * \brief Functional coverage of a dc_ram interface.
+ *
+ * Call sample_a()/sample_b() on every rising edge of clk_a/clk_b with the
+ * values that were applied at that edge. The RAM has no enable, so `en` says
+ * whether the testbench used the port in that cycle; idle cycles are not
+ * counted. A same-address access is counted when a port accesses the address
+ * the other port accessed at its last edge.
+ **/
+template <int ADDR_WIDTH> class ram_coverage : public cov_group {
+  static constexpr unsigned DEPTH = 1 << ADDR_WIDTH;
+  unsigned m_addr_a = 0, m_addr_b = 0;
+  bool m_en_a = false, m_en_b = false;
+  bool m_we_a = false, m_we_b = false;
+
+  void same_addr(bool we_this, bool we_other) {
+    same_address.hit((we_this ? 2 : 0) | (we_other ? 1 : 0));
+  }
+
+public:
+  cov_point writes_a{"writes_a", DEPTH, 1};
+  cov_point writes_b{"writes_b", DEPTH, 1};
+  cov_point reads_a{"reads_a", DEPTH, 1};
+  cov_point reads_b{"reads_b", DEPTH, 1};
+  /// bins: 0 read/read, 1 read/write, 2 write/read, 3 write/write
+  cov_point same_address{"same_address", 4, 1};
+
+  ram_coverage() : cov_group("dc_ram") {
+    for (auto p : {&writes_a, &writes_b, &reads_a, &reads_b, &same_address}) {
+      add(*p);
+    }
+    // simultaneous writes to one address are undefined, count them only
+    same_address.set_goal(3, 0);
+  }
+
+  void sample_a(bool en, bool we, unsigned addr) {
+    m_en_a = en;
+    if (!en)
+      return;
+    (we ? writes_a : reads_a).hit(addr);
+    if (m_en_b && addr == m_addr_b)
+      same_addr(we, m_we_b);
+    m_addr_a = addr;
+    m_we_a = we;
+  }
+  void sample_b(bool en, bool we, unsigned addr) {
+    m_en_b = en;
+    if (!en)
+      return;
+    (we ? writes_b : reads_b).hit(addr);
+    if (m_en_a && addr == m_addr_a)
+      same_addr(we, m_we_a);
+    m_addr_b = addr;
+    m_we_b = we;
+  }
+};
+
+#endif // COVERAGE_HPP
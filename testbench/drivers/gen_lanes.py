@@ -0,0 +1,100 @@
+#!/usr/bin/python3
+
+# Generate a SystemVerilog wrapper that instantiates LANES independent copies
+# of a module. Every port becomes an unpacked array indexed by lane, except
+# the ports listed with --shared (typically clocks), which drive all lanes.
+# Parameters of the wrapped module are passed through unchanged, so
+# -G<param>=<value> on the wrapper applies to every lane.
+#
+# Only ANSI style module headers with one port per line (the style produced
+# by verilog-format.py) are supported.
+#
+#     gen_lanes.py --module dc_fifo --shared wr_clk,rd_clk rtl/dc_fifo.sv out.sv
+
+import argparse
+import os
+import re
+import sys
+
+
+def parse_header(text, module):
+    m = re.search(r"\bmodule\s+" + module + r"\s*(#\s*\((.*?)\))?\s*\((.*?)\);",
+                  text, re.S)
+    if not m:
+        sys.exit(f"module {module} not found")
+    params = []
+    for line in (m.group(2) or "").splitlines():
+        line = line.strip().rstrip(",")
+        pm = re.match(r"parameter\s+(.*?)(\w+)\s*=\s*(.+)$", line)
+        if pm:
+            params.append((line, pm.group(2)))
+    ports = []
+    for line in m.group(3).splitlines():
+        line = re.sub(r"//.*", "", line).strip().rstrip(",")
+        pm = re.match(r"(input|output|inout)\s+(.*?)\s*(\w+)$", line)
+        if pm:
+            ports.append((pm.group(1), pm.group(2), pm.group(3)))
+    return params, ports
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("--module", required=True)
+    ap.add_argument("--shared", default="",
+                    help="comma separated ports shared by all lanes")
+    ap.add_argument("source")
+    ap.add_argument("output")
+    args = ap.parse_args()
+
+    with open(args.source) as f:
+        params, ports = parse_header(f.read(), args.module)
+    shared = set(filter(None, args.shared.split(",")))
+    for name in shared - {p[2] for p in ports}:
+        sys.exit(f"shared port {name} is not a port of {args.module}")
+
+    out = []
+    out.append(f"// Generated by gen_lanes.py from {args.source}, do not edit")
+    out.append("`default_nettype none")
+    out.append(f"module {args.module}_lanes #(")
+    out.append("    parameter LANES = 4" + ("," if params else ""))
+    out += ["    " + p[0] + ("," if i != len(params) - 1 else "")
+            for i, p in enumerate(params)]
+    out.append(") (")
+    decl = []
+    for direction, kind, name in ports:
+        dims = "" if name in shared else " [LANES]"
+        decl.append(f"    {direction} {kind} {name}{dims}")
+    out.append(",\n".join(decl))
+    out.append(");")
+    out.append("")
+    out.append("  for (genvar i = 0; i < LANES; i++) begin : lane")
+    if params:
+        out.append(f"    {args.module} #(")
+        out.append(",\n".join(f"        .{p[1]}({p[1]})" for p in params))
+        out.append("    ) dut (")
+    else:
+        out.append(f"    {args.module} dut (")
+    conns = []
+    for _, _, name in ports:
+        sig = name if name in shared else f"{name}[i]"
+        conns.append(f"        .{name}({sig})")
+    out.append(",\n".join(conns))
+    out.append("    );")
+    out.append("  end")
+    out.append("")
+    out.append(f"endmodule  // {args.module}_lanes")
+    out.append("`default_nettype wire")
+
+    text = "\n".join(out) + "\n"
+    # runs at every cmake configure: keep the timestamp when nothing changed,
+    # so the lanes model is not verilated again
+    if os.path.exists(args.output):
+        with open(args.output) as f:
+            if f.read() == text:
+                return
+    with open(args.output, "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
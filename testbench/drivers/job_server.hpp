@@ -0,0 +1,118 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef JOB_SERVER_HPP
+#define JOB_SERVER_HPP
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * \brief Line based job queue on a unix socket, served by
+ * sim_driver::run_jobs() in server mode.
+ *
+ * A client connects to the socket and sends one job per line, as space
+ * separated key=value arguments, and gets one reply line per job:
+ *
+ *     PASS <seconds>
+ *     FAIL <seconds> <message>
+ *
+ * Connections are served one after the other, each for as many jobs as the
+ * client sends. A "quit" line stops the server.
+ **/
+class job_server {
+  std::string m_path;
+  int m_listen = -1;
+  int m_conn = -1;
+  std::string m_buf;
+
+  [[noreturn]] void fail(const std::string &what) {
+    throw std::runtime_error("job_server " + m_path + ": " + what + ": " +
+                             strerror(errno));
+  }
+
+public:
+  explicit job_server(const std::string &path) : m_path(path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+      throw std::runtime_error("job_server: socket path too long: " + path);
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+    m_listen = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listen < 0)
+      fail("socket");
+    if (bind(m_listen, (sockaddr *)&addr, sizeof(addr)) < 0)
+      fail("bind");
+    if (listen(m_listen, 4) < 0)
+      fail("listen");
+  }
+  ~job_server() {
+    if (m_conn >= 0)
+      close(m_conn);
+    close(m_listen);
+    unlink(m_path.c_str());
+  }
+  job_server(const job_server &) = delete;
+  job_server &operator=(const job_server &) = delete;
+
+  /// Wait for the next job line, accepting a new connection when the current
+  /// client has gone. False once a client sent "quit".
+  bool next(std::string &line) {
+    while (true) {
+      if (auto nl = m_buf.find('\n'); nl != std::string::npos) {
+        line = m_buf.substr(0, nl);
+        m_buf.erase(0, nl + 1);
+        return line != "quit";
+      }
+      if (m_conn < 0) {
+        m_conn = accept(m_listen, nullptr, nullptr);
+        if (m_conn < 0)
+          fail("accept");
+        m_buf.clear();
+      }
+      char chunk[4096];
+      ssize_t n = read(m_conn, chunk, sizeof(chunk));
+      if (n <= 0) {
+        close(m_conn);
+        m_conn = -1;
+        continue;
+      }
+      m_buf.append(chunk, n);
+    }
+  }
+
+  /// Send one reply line; a client that went away is not an error
+  void reply(std::string line) {
+    for (auto &c : line) {
+      if (c == '\n')
+        c = ' ';
+    }
+    line += '\n';
+    if (m_conn >= 0)
+      send(m_conn, line.data(), line.size(), MSG_NOSIGNAL);
+  }
+};
+
+#endif // JOB_SERVER_HPP
@@ -0,0 +1,112 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef LANES_HPP
+#define LANES_HPP
+#include "sim_driver.hpp"
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+
+/**
+ * \brief A set of independent tests running on the lanes of a model built with
+ * add_verilator_lanes_library().
+ *
+ * lane_t is a small event driven test for one lane, constructed as
+ * lane_t(lane_index, seed, args...). It reads and drives its ports as
+ * dut->port[lane], keeps its own random generator and scoreboard, and
+ * implements `bool done() const`. Clock callbacks registered with
+ * add_callback() call the given member on every lane that is still running,
+ * so one eval() advances all lanes.
+ *
+ * An exception thrown by a lane marks only that lane as failed; the other
+ * lanes keep running. check() throws a summary of every failed lane with its
+ * seed, so a failure can be reproduced with that seed on a single lane.
+ **/
+template <typename lane_t> class lane_set {
+  struct entry_t {
+    lane_t test;
+    uint32_t seed;
+    bool failed = false;
+    std::string error;
+    template <typename... args_t>
+    entry_t(int lane, uint32_t seed, args_t &&...args)
+        : test(lane, seed, args...), seed(seed) {}
+  };
+  // deque: lanes are built in place and never move, so lane_t does not need
+  // to be copyable
+  std::deque<entry_t> m_lanes;
+
+public:
+  template <typename... args_t>
+  lane_set(int n_lanes, uint32_t base_seed, args_t &&...args) {
+    for (int i = 0; i < n_lanes; ++i) {
+      m_lanes.emplace_back(i, base_seed + i, args...);
+    }
+  }
+
+  /// call fn on every running lane on the given edge of clock cd
+  void add_callback(ClockDriver &cd, void (lane_t::*fn)(),
+                    ClockDriver::edge_e e = ClockDriver::edge_e::RISE_EDGE) {
+    cd.add_callback([this, fn](ClockDriver::edge_e) { for_each(fn); }, e);
+  }
+
+  void for_each(void (lane_t::*fn)()) {
+    for (auto &l : m_lanes) {
+      if (l.failed || l.test.done())
+        continue;
+      try {
+        (l.test.*fn)();
+      } catch (std::exception &e) {
+        l.failed = true;
+        l.error = e.what();
+      }
+    }
+  }
+
+  /// true once every lane has finished or failed
+  bool all_done() const {
+    for (auto &l : m_lanes) {
+      if (!l.failed && !l.test.done())
+        return false;
+    }
+    return true;
+  }
+
+  /// throw if any lane failed, listing each failure with its seed
+  void check() const {
+    std::string msg;
+    for (unsigned i = 0; i < m_lanes.size(); ++i) {
+      auto &l = m_lanes[i];
+      if (l.failed) {
+        msg += "lane " + std::to_string(i) + " seed=" + std::to_string(l.seed) +
+               ": " + l.error + "\n";
+      }
+    }
+    if (!msg.empty())
+      throw std::runtime_error(msg);
+  }
+
+  size_t size() const { return m_lanes.size(); }
+  lane_t &operator[](size_t i) { return m_lanes[i].test; }
+};
+
+#endif // LANES_HPP
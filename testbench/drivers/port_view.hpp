@@ -0,0 +1,100 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef PORT_VIEW_HPP
+#define PORT_VIEW_HPP
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+/**
+ * \brief The storage of a dut port as N words of word_t, LSW first. load()
+ *and store() copy a whole transaction word in or out with one memcpy.
+ *
+ * Bits above the port width must be zero in what is loaded, as for any
+ *write to a Verilator input.
+ **/
+template <typename word_t, std::size_t N> class port_words {
+  word_t *m_words;
+
+  template <typename T> static constexpr void check() {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "transaction words are copied as bytes");
+    static_assert(sizeof(T) == N * sizeof(word_t),
+                  "transaction word and port differ in size");
+  }
+
+public:
+  using word_type = word_t;
+  static constexpr std::size_t words = N;
+  static constexpr std::size_t bytes = N * sizeof(word_t);
+
+  explicit port_words(word_t *words) : m_words(words) {}
+  std::span<word_t, N> span() const { return std::span<word_t, N>(m_words, N); }
+  template <typename T> void load(const T &value) {
+    check<T>();
+    memcpy(m_words, &value, bytes);
+  }
+  template <typename T> void store(T &value) const {
+    check<T>();
+    memcpy(&value, m_words, bytes);
+  }
+};
+
+/**
+ * \brief Bulk access to a dut port, see port_words. This covers ports held in
+ *one integer (Verilator's CData to QData); verilator_driver.hpp specializes
+ *it for VlWide ports and xsim_driver.hpp for sim_port, which has no
+ *contiguous storage and so no span().
+ *
+ *     std::array<uint64_t, 8> word;
+ *     port_view(dut->wr_din).load(word);
+ **/
+template <typename port_t> class port_view : public port_words<port_t, 1> {
+  static_assert(std::is_integral_v<port_t>, "no port_view for this port type");
+
+public:
+  explicit port_view(port_t &port) : port_words<port_t, 1>(&port) {}
+};
+template <typename port_t> port_view(port_t &) -> port_view<port_t>;
+
+/// Drive a transaction word onto a port: an assignment where the port takes
+/// T, a port_view::load() otherwise (wide ports)
+template <typename T, typename port_t> void port_put(port_t &port, const T &v) {
+  if constexpr (std::is_assignable_v<port_t &, const T &>) {
+    port = v;
+  } else {
+    port_view<port_t>(port).load(v);
+  }
+}
+
+/// Read a port as a transaction word, see port_put()
+template <typename T, typename port_t> T port_get(port_t &port) {
+  if constexpr (std::is_convertible_v<const port_t &, T>) {
+    return T(port);
+  } else {
+    T v;
+    port_view<port_t>(port).store(v);
+    return v;
+  }
+}
+
+#endif // PORT_VIEW_HPP
@@ -0,0 +1,85 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef PROBE_HPP
+#define PROBE_HPP
+#include "sim_driver.hpp"
+#include <vector>
+
+/**
+ * \brief Read-only view of a signal that the simulator keeps in memory, as
+ *returned by verilator_driver::probe(). Reading it is one load.
+ **/
+template <typename T> class probe_ref {
+  const T *m_data;
+
+public:
+  using value_type = T;
+  explicit probe_ref(const T *data) : m_data(data) {}
+  T operator*() const { return *m_data; }
+  operator T() const { return *m_data; }
+};
+
+/**
+ * \brief Samples of one probe taken on a clock edge, in a buffer allocated
+ *up front so that sampling never allocates. Samples beyond the capacity are
+ *counted in dropped().
+ *
+ *     auto used = probe<CData>("TOP.dc_fifo.sim_used");
+ *     probe_buffer used_log(used, 100000);
+ *     used_log.attach(wr_clock);
+ **/
+template <typename probe_t> class probe_buffer {
+public:
+  using value_type = typename probe_t::value_type;
+
+private:
+  probe_t m_probe;
+  std::vector<value_type> m_samples;
+  size_t m_size = 0;
+  uint64_t m_dropped = 0;
+
+public:
+  probe_buffer(probe_t probe, size_t capacity)
+      : m_probe(probe), m_samples(capacity) {}
+  /// Sample on every `edge` of clock, after the design reacted to it
+  void attach(ClockDriver &clock,
+              ClockDriver::edge_e edge = ClockDriver::edge_e::RISE_EDGE) {
+    clock.add_callback([this](ClockDriver::edge_e) { sample(); }, edge);
+  }
+  void sample() {
+    if (m_size < m_samples.size()) {
+      m_samples[m_size++] = *m_probe;
+    } else {
+      m_dropped++;
+    }
+  }
+  void clear() {
+    m_size = 0;
+    m_dropped = 0;
+  }
+  size_t size() const { return m_size; }
+  uint64_t dropped() const { return m_dropped; }
+  const value_type &operator[](size_t i) const { return m_samples[i]; }
+  const value_type *begin() const { return m_samples.data(); }
+  const value_type *end() const { return m_samples.data() + m_size; }
+};
+
+#endif // PROBE_HPP
@@ -20,17 +20,34 @@
 
 #ifndef SIM_DRIVER_HPP
 #define SIM_DRIVER_HPP
+#include "port_view.hpp"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <ratio>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <sys/types.h>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// run_jobs() serves jobs through it, tests that call it include job_server.hpp
+class job_server;
 
 #define debug(a)                                                               \
   printf("%s:%d %s = %lld\n", __FILE__, __LINE__, #a, (long long)(a))
@@ -109,6 +126,12 @@ public:
     }
   }
   duration_t get_period() const { return down_time + up_time; }
+  /// change the period, takes effect from the next edge
+  void set_period(std::chrono::duration<long double, std::nano> period) {
+    duration_t dur_period(int(period.count() * 1000));
+    up_time = dur_period / 2;
+    down_time = dur_period - up_time;
+  }
   duration_t last_update() const { return m_last_update; }
   void update(duration_t now) {
     clk_val = !clk_val;
@@ -127,11 +150,90 @@ public:
   }
 };
 
-class sim_driver {
+/**
+ * \brief A condition on one DUT signal, checked after each simulation step.
+ *Made by sim_driver_base::watch_change() and friends, used with add_watch()
+ *and run_until(). The signal may be anything that converts to an integer of
+ *up to 64 bits: a Verilator port, a sim_port or a probe (probe_ref,
+ *xsi_probe). It is read through a plain function pointer, so checking a watch
+ *costs one load and compare. Wider ports (VlWide, sim_port above 64 bits)
+ *are rejected at compile time, since only their low word would be compared.
+ **/
+class signal_watch {
+public:
+  enum class kind_e { CHANGE, RISE, FALL, EQUALS };
+
+private:
+  uint64_t (*m_sample)(const void *);
+  const void *m_pin;
+  uint64_t m_last;
+  uint64_t m_value;
+  kind_e m_kind;
+
+  template <typename pin_t> static uint64_t sample_pin(const void *pin) {
+    return uint64_t(*static_cast<const pin_t *>(pin));
+  }
+  /// Size of the watched value: a port's storage, a probe's value_type
+  template <typename pin_t, typename = void> struct pin_bytes {
+    static constexpr size_t value = port_view<pin_t>::bytes;
+  };
+  template <typename pin_t>
+  struct pin_bytes<pin_t, std::void_t<typename pin_t::value_type>> {
+    static constexpr size_t value = sizeof(typename pin_t::value_type);
+  };
+
+public:
+  template <typename pin_t>
+  signal_watch(const pin_t &pin, kind_e kind, uint64_t value = 0)
+      : m_sample(&sample_pin<pin_t>), m_pin(&pin), m_value(value),
+        m_kind(kind) {
+    static_assert(pin_bytes<pin_t>::value <= sizeof(uint64_t),
+                  "signal_watch compares 64 bits, watch a narrower signal");
+    arm();
+  }
+  // the watch keeps a pointer to the signal
+  template <typename pin_t>
+  signal_watch(const pin_t &&, kind_e, uint64_t = 0) = delete;
+
+  /// Take the current value as the reference, only changes after this count
+  void arm() { m_last = m_sample(m_pin); }
+  /// True while an EQUALS watch's signal has the value, false for the others
+  bool holds() const {
+    return m_kind == kind_e::EQUALS && m_sample(m_pin) == m_value;
+  }
+  /// Sample the signal, true if it changed since the last check: at all
+  /// (CHANGE), from 0 to non-zero (RISE), to 0 (FALL) or to the value (EQUALS)
+  bool check() {
+    uint64_t v = m_sample(m_pin);
+    if (v == m_last)
+      return false;
+    uint64_t last = m_last;
+    m_last = v;
+    switch (m_kind) {
+    case kind_e::CHANGE:
+      return true;
+    case kind_e::RISE:
+      return last == 0;
+    case kind_e::FALL:
+      return v == 0;
+    case kind_e::EQUALS:
+      return v == m_value;
+    }
+    return false;
+  }
+};
+
+/**
+ * \brief State shared by every driver: command line arguments, clocks, trace
+ *settings and the add_thread() barrier. Drivers derive from sim_driver<>
+ *below, which adds the statically dispatched step.
+ **/
+class sim_driver_base {
 protected:
   using duration_t = ClockDriver::duration_t;
   std::unordered_map<std::string, std::string> cmd_line_args;
-  std::vector<ClockDriver> m_clocks;
+  // deque so the references returned by add_clock() stay valid
+  std::deque<ClockDriver> m_clocks;
   /**
    * \brief Parse the command line arguments of form key=value, stor as
    *unordered_map member variable cmd_line_args \returns the last arg as the
@@ -148,48 +250,181 @@ protected:
       auto eq_index = arg.find("=");
       if (eq_index != std::string::npos) {
         auto key = arg.substr(0, eq_index);
-        auto value = arg.substr(eq_index, std::string::npos);
+        auto value = arg.substr(eq_index + 1, std::string::npos);
         cmd_line_args[key] = value;
       } else {
         waveform_file = arg;
       }
     }
+    parse_trace_args();
+    if (auto wall = get_cmd_line_arg("wall_timeout"); wall != "") {
+      set_wall_timeout(std::chrono::duration<double>(std::stod(wall)));
+    }
+    start_watchdog();
     return waveform_file;
   }
-  duration_t sim_timeout;
-  /*set timout relative to NOW */
-  void set_sim_timeout(duration_t timeout) {
-    sim_timeout = get_now() + timeout;
+  /// value of a key=value command line argument, or default_value if absent
+  std::string get_cmd_line_arg(const std::string &key,
+                               const std::string &default_value = "") const {
+    auto it = cmd_line_args.find(key);
+    return it == cmd_line_args.end() ? default_value : it->second;
+  }
+
+  /// Part of the design hierarchy to trace, see add_trace_scope()
+  struct trace_scope_t {
+    std::string hier;
+    int depth;
+  };
+  std::vector<trace_scope_t> trace_scopes;
+  int trace_depth = 0;
+
+  /**
+   * \brief Trace only the hierarchy below `hier`, `depth` levels deep (0 for
+   *all levels below it). hier is the scope as shown in the waveform viewer,
+   *e.g. TOP.dc_fifo.cc_wptr. Without any scope the whole design is traced,
+   *trace_depth levels deep. Must be called before the first step.
+   *
+   * Command line: trace_depth=N and trace_scope=hier[:depth][,hier[:depth]]
+   **/
+  void add_trace_scope(const std::string &hier, int depth = 0) {
+    trace_scopes.push_back({hier, depth});
+  }
+  void set_trace_depth(int depth) { trace_depth = depth; }
+
+  void parse_trace_args() {
+    trace_depth = std::stoi(get_cmd_line_arg("trace_depth", "0"));
+    std::string scopes = get_cmd_line_arg("trace_scope");
+    size_t start = 0;
+    while (start < scopes.size()) {
+      size_t end = scopes.find(',', start);
+      if (end == std::string::npos)
+        end = scopes.size();
+      std::string scope = scopes.substr(start, end - start);
+      auto colon = scope.find(':');
+      if (colon == std::string::npos) {
+        add_trace_scope(scope);
+      } else {
+        add_trace_scope(scope.substr(0, colon),
+                        std::stoi(scope.substr(colon + 1)));
+      }
+      start = end + 1;
+    }
+  }
+
+  /// Sim-time budget, absolute, 0 disables it. Enforced by the watchdog on
+  /// the sim time main reports when polled, so a run stops within a few
+  /// WATCHDOG_POLL periods of passing it.
+  std::atomic<duration_t> sim_timeout;
+
+  /// Wall-clock budget, counted from this call (from start_watchdog() for
+  /// the command line budget). Enforced by the watchdog, 0 disables it.
+  /// Command line: wall_timeout=S
+  void set_wall_timeout(std::chrono::duration<double> timeout) {
+    std::lock_guard lock(m_watchdog_mutex);
+    m_wall_timeout = timeout;
+    m_wall_start = std::chrono::steady_clock::now();
+  }
+  std::chrono::duration<double> get_wall_timeout() {
+    std::lock_guard lock(m_watchdog_mutex);
+    return m_wall_timeout;
   }
 
 private:
+  // Barrier atomics each get their own cache line so that children polling
+  // generation don't keep stealing the line main updates bar on (and vice
+  // versa).
+  static constexpr size_t CACHE_LINE = 64;
+
   // Packed barrier state: low 32 bits = arrived count, high 32 bits =
   // n_active. Combined into one atomic so main can wait on both halves at
   // once — any change to either half wakes the wait. This eliminates the
   // need for a "phantom arrival" trick and ensures main always waits for
   // every alive child to actually arrive each round.
-  std::atomic<uint64_t> bar{0};
-  std::atomic<size_t> generation{0};
-  std::atomic<bool> stopping{false};
-  std::thread::id main_tid;
+  alignas(CACHE_LINE) std::atomic<uint64_t> bar{0};
+  alignas(CACHE_LINE) std::atomic<size_t> generation{0};
+  alignas(CACHE_LINE) std::atomic<bool> stopping{false};
+  alignas(CACHE_LINE) std::thread::id main_tid;
   std::vector<std::thread> threads;
 
   static constexpr uint64_t ARRIVED_MASK = 0xFFFFFFFFULL;
   static constexpr uint64_t N_ACTIVE_INC = 1ULL << 32;
+  // Set in bar by the watchdog so that main, blocked waiting for a child that
+  // will never arrive, sees the value change and wakes up.
+  static constexpr uint64_t ABORT_BIT = 1ULL << 63;
   static uint32_t arrived_of(uint64_t s) { return uint32_t(s); }
-  static uint32_t n_active_of(uint64_t s) { return uint32_t(s >> 32); }
+  static uint32_t n_active_of(uint64_t s) {
+    return uint32_t(s >> 32) & 0x7FFFFFFF;
+  }
+
+  /// What an add_thread() child is doing, for the watchdog report
+  enum class child_state : uint8_t { RUNNING, WAITING, RETURNED, STOPPED };
+  struct child_info {
+    std::atomic<child_state> state{child_state::RUNNING};
+    std::atomic<uint64_t> steps{0};
+  };
+  // guarded by m_watchdog_mutex, deque so tl_child stays valid
+  std::deque<child_info> m_children;
+  static inline thread_local child_info *tl_child = nullptr;
+
+  static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
 
-  duration_t update_no_threads() { return _update(); }
+  /// Spin-then-block waiting: before falling back to atomic::wait() (a
+  /// futex syscall plus a wake-up on the other side), a waiter polls for up
+  /// to `limit` iterations. The limit doubles towards the observed wait when
+  /// spinning succeeds and halves when it has to block, so it settles on the
+  /// typical latency of the other side of the barrier. Each waiting thread
+  /// keeps its own budget, never above max_spin.
+  struct spin_budget {
+    static constexpr uint32_t MIN_SPIN = 16;
+    uint32_t limit;
+    explicit spin_budget(uint32_t max_spin)
+        : limit(std::min<uint32_t>(1024, max_spin)) {}
+    template <typename ready_t> bool spin(uint32_t max_spin, ready_t ready) {
+      if (max_spin == 0)
+        return ready();
+      for (uint32_t i = 0; i < limit; ++i) {
+        if (ready()) {
+          if (2 * i > limit)
+            limit = std::min(max_spin, 2 * i);
+          return true;
+        }
+        cpu_relax();
+      }
+      limit = std::min(max_spin, std::max(MIN_SPIN, limit / 2));
+      return false;
+    }
+  };
+  /// upper bound for spin_budget::limit, 0 disables spinning. Spinning only
+  /// helps when the other side of the barrier has a core.
+  uint32_t max_spin = std::thread::hardware_concurrency() > 1 ? 1 << 16 : 0;
+  spin_budget main_spin{max_spin};
 
-  duration_t update_with_threads() {
+protected:
+  /// One step of a driver with child threads: main waits for every child to
+  /// arrive, runs `step` and releases them; children return 0 once released.
+  template <typename step_t> duration_t update_with_threads(step_t step) {
     if (std::this_thread::get_id() == main_tid) {
-      while (true) {
+      auto all_arrived = [this] {
         uint64_t s = bar.load(std::memory_order_acquire);
-        if (arrived_of(s) >= n_active_of(s))
-          break;
-        bar.wait(s, std::memory_order_acquire);
+        return arrived_of(s) >= n_active_of(s);
+      };
+      if (!main_spin.spin(max_spin, all_arrived)) {
+        while (true) {
+          uint64_t s = bar.load(std::memory_order_acquire);
+          if (s & ABORT_BIT)
+            watchdog_expired();
+          if (arrived_of(s) >= n_active_of(s))
+            break;
+          bar.wait(s, std::memory_order_acquire);
+        }
       }
-      duration_t d = _update();
+      duration_t d = step();
       // Clear the arrived (low) half while preserving n_active (high half).
       // CAS loop because wrappers may concurrently decrement n_active.
       uint64_t old = bar.load(std::memory_order_relaxed);
@@ -201,21 +436,31 @@ private:
       generation.notify_all();
       return d;
     } else {
+      static thread_local spin_budget child_spin(max_spin);
       if (stopping.load(std::memory_order_acquire))
         throw thread_stop{};
       auto my_gen = generation.load(std::memory_order_acquire);
+      tl_child->state.store(child_state::WAITING, std::memory_order_relaxed);
       bar.fetch_add(1, std::memory_order_acq_rel);
       bar.notify_one();
-      while (true) {
-        size_t g = generation.load(std::memory_order_acquire);
-        if (g != my_gen)
-          break;
-        if (stopping.load(std::memory_order_acquire))
-          throw thread_stop{};
-        generation.wait(my_gen, std::memory_order_acquire);
+      auto released = [this, my_gen] {
+        return generation.load(std::memory_order_acquire) != my_gen;
+      };
+      if (!child_spin.spin(max_spin, released)) {
+        while (true) {
+          size_t g = generation.load(std::memory_order_acquire);
+          if (g != my_gen)
+            break;
+          if (stopping.load(std::memory_order_acquire))
+            throw thread_stop{};
+          generation.wait(my_gen, std::memory_order_acquire);
+        }
       }
       if (stopping.load(std::memory_order_acquire))
         throw thread_stop{};
+      tl_child->state.store(child_state::RUNNING, std::memory_order_relaxed);
+      tl_child->steps.store(tl_child->steps.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
       return duration_t(0);
     }
   }
@@ -227,25 +472,130 @@ public:
   /// explicitly if cleanup is needed before unwinding.
   struct thread_stop {};
 
-protected:
-  /// Per-step hook. Defaults to a direct _update() call (no synchronization
-  /// overhead). Swapped to a barrier-rendezvous version on the first
-  /// add_thread() call. Throws thread_stop from a child thread on shutdown.
-  /// Returns the sim-time duration consumed by the step (0 in child threads).
-  std::function<duration_t()> update;
+private:
+  /**
+   * Watchdog: a thread that polls every WATCHDOG_POLL and fires when the
+   *sim-time or the wall-clock budget runs out. It never touches the model:
+   *each poll raises STEP_SAMPLE, and main publishes its sim time and step
+   *count after the next step, so a step without a request costs nothing but
+   *the flag load in update(). Firing raises STEP_EXPIRED, so the next
+   *update() on main throws, sets ABORT_BIT to wake main if it is blocked in
+   *the barrier, and stops the children. If the driver has not shut down
+   *within WATCHDOG_GRACE, e.g. because a child is stuck outside update(), it
+   *reports again and exits the process, unless reset_watchdog() re-armed it
+   *for the next run_jobs() job.
+   **/
+  static constexpr auto WATCHDOG_POLL = std::chrono::milliseconds(10);
+  static constexpr auto WATCHDOG_GRACE = std::chrono::seconds(10);
+  std::thread m_watchdog;
+  std::mutex m_watchdog_mutex;
+  std::condition_variable m_watchdog_cv;
+  bool m_watchdog_stop = false;
+  std::chrono::duration<double> m_wall_timeout{0};
+  std::chrono::steady_clock::time_point m_wall_start;
+  // written before STEP_EXPIRED is raised
+  std::string m_expired_reason;
+  // step rate at the last poll, for the report
+  double m_steps_per_sec = 0;
 
-  sim_driver() : main_tid(std::this_thread::get_id()) {
-    sim_timeout = std::chrono::milliseconds(10);
-    update = [this] { return update_no_threads(); };
+  // published by main on STEP_SAMPLE, read by the watchdog
+  alignas(CACHE_LINE) std::atomic<duration_t> m_progress_now{duration_t(0)};
+  std::atomic<uint64_t> m_progress_steps{0};
+
+  void watchdog_report(const std::string &reason, double steps_per_sec) {
+    fprintf(stderr, "watchdog: %s\n", reason.c_str());
+    fprintf(stderr, "  sim time %.3f ns, %llu steps, %.0f steps/s\n",
+            m_progress_now.load(std::memory_order_relaxed).count() / 1000.0,
+            (unsigned long long)m_progress_steps.load(std::memory_order_relaxed),
+            steps_per_sec);
+    if (m_children.empty())
+      return;
+    uint64_t s = bar.load(std::memory_order_relaxed);
+    fprintf(stderr, "  barrier: %u of %u children arrived\n", arrived_of(s),
+            n_active_of(s));
+    static const char *names[] = {"running", "waiting at the barrier",
+                                  "returned", "stopped"};
+    for (unsigned i = 0; i < m_children.size(); ++i) {
+      auto &c = m_children[i];
+      fprintf(stderr, "  child %u: %s, %llu steps\n", i,
+              names[int(c.state.load(std::memory_order_relaxed))],
+              (unsigned long long)c.steps.load(std::memory_order_relaxed));
+    }
+    fflush(stderr);
   }
-  ~sim_driver() { shutdown(); }
 
-  /// Stop and join all child threads. Idempotent. Must be called as the
-  /// first line of every derived destructor (before deleting the DUT) so
-  /// child threads can't touch a freed DUT.
-  void shutdown() noexcept {
-    if (stopping.exchange(true, std::memory_order_acq_rel))
+  /// Report, raise STEP_EXPIRED and stop the children. Called with
+  /// m_watchdog_mutex held; only the first budget to run out is reported.
+  void expire(const std::string &reason) {
+    if (m_step_flags.load(std::memory_order_relaxed) & STEP_EXPIRED)
       return;
+    m_expired_reason = reason;
+    watchdog_report(reason, m_steps_per_sec);
+    m_step_flags.fetch_or(STEP_EXPIRED, std::memory_order_release);
+    bar.fetch_or(ABORT_BIT, std::memory_order_release);
+    bar.notify_all();
+    request_stop();
+  }
+
+  void watchdog_main() {
+    using clock = std::chrono::steady_clock;
+    std::unique_lock lock(m_watchdog_mutex);
+    uint64_t last_steps = 0;
+    auto last_poll = clock::now();
+    auto expired = [this] {
+      return m_step_flags.load(std::memory_order_relaxed) & STEP_EXPIRED;
+    };
+    while (true) {
+      if (expired()) {
+        if (!m_watchdog_cv.wait_for(lock, WATCHDOG_GRACE, [&] {
+              return m_watchdog_stop || !expired();
+            })) {
+          watchdog_report("simulation did not stop, exiting", 0);
+          std::_Exit(EXIT_FAILURE);
+        }
+        if (m_watchdog_stop)
+          return;
+        // re-armed by reset_watchdog()
+        continue;
+      }
+      if (m_watchdog_cv.wait_for(lock, WATCHDOG_POLL,
+                                 [this] { return m_watchdog_stop; }))
+        return;
+      auto now = clock::now();
+      uint64_t steps = m_progress_steps.load(std::memory_order_relaxed);
+      std::chrono::duration<double> dt = now - last_poll;
+      m_steps_per_sec = (steps - last_steps) / dt.count();
+      last_steps = steps;
+      last_poll = now;
+
+      duration_t sim_now = m_progress_now.load(std::memory_order_relaxed);
+      duration_t budget = sim_timeout.load(std::memory_order_relaxed);
+      if (budget != duration_t(0) && sim_now >= budget) {
+        expire("Simulation timed out at " +
+               std::to_string(sim_now.count() / 1000) + " ns");
+      }
+      if (m_wall_timeout.count() > 0 && now - m_wall_start >= m_wall_timeout) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "Wall-clock budget of %g s exceeded",
+                 m_wall_timeout.count());
+        expire(buf);
+      }
+      m_step_flags.fetch_or(STEP_SAMPLE, std::memory_order_relaxed);
+    }
+  }
+
+  /// Throw out of update() once the watchdog fired: the budget message on
+  /// main, thread_stop in the children
+  [[noreturn]] void watchdog_expired() {
+    if (std::this_thread::get_id() != main_tid)
+      throw thread_stop{};
+    std::lock_guard lock(m_watchdog_mutex);
+    throw std::runtime_error(m_expired_reason);
+  }
+
+  /// Wake every child and make it throw thread_stop, without joining
+  void request_stop() noexcept {
+    stopping.store(true, std::memory_order_release);
     // Bump generation so any child currently inside generation.wait() sees a
     // value change and returns (atomic::wait would otherwise block forever
     // because notify_all races with wait — notify is not queued for late
@@ -253,11 +603,160 @@ protected:
     generation.fetch_add(1, std::memory_order_release);
     generation.notify_all();
     bar.notify_all();
+  }
+
+  void stop_watchdog() noexcept {
+    {
+      std::lock_guard lock(m_watchdog_mutex);
+      m_watchdog_stop = true;
+    }
+    m_watchdog_cv.notify_all();
+    if (m_watchdog.joinable())
+      m_watchdog.join();
+  }
+
+protected:
+  /// Checked once per step by update(); any bit set takes the slow path.
+  /// STEP_THREADED is set by the first add_thread(), after which every step
+  /// goes through update_with_threads(), STEP_START until the first step has
+  /// called derived_t::start(), STEP_EXPIRED and STEP_SAMPLE by the watchdog.
+  static constexpr uint8_t STEP_THREADED = 1;
+  static constexpr uint8_t STEP_START = 2;
+  static constexpr uint8_t STEP_EXPIRED = 4;
+  static constexpr uint8_t STEP_SAMPLE = 8;
+  std::atomic<uint8_t> m_step_flags{STEP_START};
+
+  /// Steps run by main, read only by main
+  uint64_t m_steps = 0;
+  /// Answer a STEP_SAMPLE request of the watchdog, after a step on main
+  void publish_progress(duration_t now) {
+    m_step_flags.fetch_and(~STEP_SAMPLE, std::memory_order_relaxed);
+    m_progress_now.store(now, std::memory_order_relaxed);
+    m_progress_steps.store(m_steps, std::memory_order_relaxed);
+  }
+  void check_watchdog() {
+    if (m_step_flags.load(std::memory_order_acquire) & STEP_EXPIRED)
+      watchdog_expired();
+  }
+  /// Clear an expired budget and disable both budgets, so that main can run
+  /// again. Only without child threads, which expire() stopped for good.
+  void reset_watchdog() {
+    {
+      std::lock_guard lock(m_watchdog_mutex);
+      m_step_flags.fetch_and(~STEP_EXPIRED, std::memory_order_relaxed);
+      bar.fetch_and(~ABORT_BIT, std::memory_order_relaxed);
+      stopping.store(false, std::memory_order_relaxed);
+      m_expired_reason.clear();
+      sim_timeout = duration_t(0);
+      m_wall_timeout = std::chrono::duration<double>(0);
+      m_progress_now.store(duration_t(0), std::memory_order_relaxed);
+    }
+    m_watchdog_cv.notify_all();
+  }
+
+  /// Start the watchdog enforcing sim_timeout and the wall-clock budget.
+  /// Called by parse_cmd_line_args(); later calls do nothing.
+  void start_watchdog() {
+    if (m_watchdog.joinable())
+      return;
+    m_wall_start = std::chrono::steady_clock::now();
+    m_watchdog = std::thread([this] { watchdog_main(); });
+  }
+
+  sim_driver_base() : main_tid(std::this_thread::get_id()) {
+    sim_timeout = std::chrono::milliseconds(10);
+  }
+  ~sim_driver_base() { shutdown(); }
+
+  /// Stop and join all child threads, then the watchdog. Idempotent. Must be
+  /// called as the first line of every derived destructor (before deleting
+  /// the DUT) so child threads can't touch a freed DUT. The watchdog is
+  /// stopped last so it still covers a child that never stops.
+  void shutdown() noexcept {
+    request_stop();
     for (auto &t : threads) {
       if (t.joinable())
         t.join();
     }
     threads.clear();
+    stop_watchdog();
+  }
+
+  /// Clocks as they were at save_clocks(), callbacks included
+  std::vector<ClockDriver> m_saved_clocks;
+  void save_clocks() {
+    m_saved_clocks.assign(m_clocks.begin(), m_clocks.end());
+  }
+  /// Put the clocks back in their saved state, dropping callbacks added since.
+  /// The clock nets themselves are restored with the model.
+  void restore_clocks() {
+    except_assert2(m_clocks.size() == m_saved_clocks.size(),
+                   "clock added after the state was saved");
+    std::copy(m_saved_clocks.begin(), m_saved_clocks.end(), m_clocks.begin());
+  }
+
+  /// Watches for run_until() and add_watch(), armed with the current value
+  template <typename pin_t> static signal_watch watch_change(const pin_t &pin) {
+    return signal_watch(pin, signal_watch::kind_e::CHANGE);
+  }
+  template <typename pin_t> static signal_watch watch_rise(const pin_t &pin) {
+    return signal_watch(pin, signal_watch::kind_e::RISE);
+  }
+  template <typename pin_t> static signal_watch watch_fall(const pin_t &pin) {
+    return signal_watch(pin, signal_watch::kind_e::FALL);
+  }
+  template <typename pin_t>
+  static signal_watch watch_equals(const pin_t &pin, uint64_t value) {
+    return signal_watch(pin, signal_watch::kind_e::EQUALS, value);
+  }
+
+  struct watch_entry {
+    signal_watch watch;
+    std::function<void()> handler;
+    size_t id;
+  };
+  std::vector<watch_entry> m_watches;
+  size_t m_next_watch_id = 0;
+  bool m_watches_removed = false;
+
+  /**
+   * \brief Call handler after every step in which watch fires, e.g.
+   *add_watch(watch_rise(dut->wr_full), [&] { full_events++; }). Only the
+   *watched signals are compared after each step, in the order the watches
+   *were added, on the main thread once every clock callback ran.
+   *\returns an id for remove_watch()
+   **/
+  size_t add_watch(signal_watch watch, std::function<void()> handler) {
+    m_watches.push_back({watch, std::move(handler), m_next_watch_id});
+    return m_next_watch_id++;
+  }
+  /// Stop a watch, also from within its own handler
+  void remove_watch(size_t id) {
+    for (auto &w : m_watches) {
+      if (w.id == id && w.handler) {
+        w.handler = nullptr;
+        m_watches_removed = true;
+      }
+    }
+  }
+  /// Re-read every watched signal, after the model state was replaced
+  void arm_watches() {
+    for (auto &w : m_watches) {
+      w.watch.arm();
+    }
+  }
+  void check_watches() {
+    // by index and on a copy of the handler, which may add or remove watches
+    for (size_t i = 0; i < m_watches.size(); ++i) {
+      if (m_watches[i].handler && m_watches[i].watch.check()) {
+        auto handler = m_watches[i].handler;
+        handler();
+      }
+    }
+    if (m_watches_removed) {
+      std::erase_if(m_watches, [](auto &w) { return !w.handler; });
+      m_watches_removed = false;
+    }
   }
 
   template <typename pin_t>
@@ -269,33 +768,107 @@ protected:
   }
 
   /// Spawn a child thread that participates in the per-step barrier. The
-  /// first call swaps update() over to the barrier-rendezvous version. All
+  /// first call switches update() over to the barrier-rendezvous version. All
   /// add_thread calls must precede the first update() call. The thread
   /// function is wrapped to catch thread_stop, so child loops can be written
   /// as bare infinite loops and unwind cleanly at shutdown. A thread may also
   /// return early on its own — n_active is decremented and main is notified
   /// so it doesn't deadlock waiting for an arrival that will never come.
+  ///
+  /// Command line options (key=value, read on each call):
+  ///   barrier_spin=N  spin at most N iterations before blocking, 0 = never
+  ///   pin_threads=1   pin child thread i to CPU i+1 (main is expected on 0)
   void add_thread(std::function<void()> fn) {
+    if (auto spin = get_cmd_line_arg("barrier_spin"); spin != "") {
+      max_spin = std::stoul(spin);
+      main_spin = spin_budget(max_spin);
+    }
     uint64_t old = bar.fetch_add(N_ACTIVE_INC, std::memory_order_acq_rel);
     if (n_active_of(old) == 0) {
-      update = [this] { return update_with_threads(); };
+      m_step_flags.fetch_or(STEP_THREADED, std::memory_order_relaxed);
+    }
+    child_info *info;
+    {
+      std::lock_guard lock(m_watchdog_mutex);
+      info = &m_children.emplace_back();
     }
-    threads.emplace_back([this, fn = std::move(fn)] {
+    threads.emplace_back([this, info, fn = std::move(fn)] {
+      tl_child = info;
       try {
         fn();
+        info->state.store(child_state::RETURNED, std::memory_order_relaxed);
       } catch (thread_stop &) {
+        info->state.store(child_state::STOPPED, std::memory_order_relaxed);
       }
       bar.fetch_sub(N_ACTIVE_INC, std::memory_order_acq_rel);
       bar.notify_one();
     });
+#if defined(__linux__)
+    if (get_cmd_line_arg("pin_threads") == "1") {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(threads.size() % std::thread::hardware_concurrency(), &cpus);
+      pthread_setaffinity_np(threads.back().native_handle(), sizeof(cpus),
+                             &cpus);
+    }
+#endif
   }
 
   /// True until shutdown() is called. Use from child-thread loops to break
   /// out cleanly when the driver is being destroyed.
   bool is_running() const { return !stopping.load(std::memory_order_acquire); }
 
-  virtual duration_t get_now() = 0;
-  virtual duration_t _update() = 0;
+};
+
+/**
+ * \brief CRTP front end of sim_driver_base. derived_t implements
+ *duration_t get_now() and duration_t _update(), one simulation step returning
+ *the sim time it advanced, and void start(), called before the first step
+ *once the test constructor has set everything up. It befriends
+ *sim_driver<derived_t> if they are not public. Without child threads
+ *update() and the run helpers call _update() directly, so the step inlines
+ *into the test's loops.
+ **/
+template <typename derived_t> class sim_driver : protected sim_driver_base {
+  derived_t &self() { return static_cast<derived_t &>(*this); }
+
+  duration_t step_and_watch() {
+    duration_t d = self()._update();
+    ++m_steps;
+    if (!m_watches.empty())
+      check_watches();
+    return d;
+  }
+  duration_t update_slow() {
+    check_watchdog();
+    // the step runs on main only, with the children parked in the barrier
+    return update_with_threads([this] {
+      if (m_step_flags.load(std::memory_order_relaxed) & STEP_START) {
+        m_step_flags.fetch_and(~STEP_START, std::memory_order_relaxed);
+        self().start();
+      }
+      duration_t d = step_and_watch();
+      if (m_step_flags.load(std::memory_order_relaxed) & STEP_SAMPLE)
+        publish_progress(self().get_now());
+      return d;
+    });
+  }
+
+protected:
+  /// One simulation step, a barrier rendezvous once add_thread() has been
+  /// called. Throws thread_stop from a child thread on shutdown and
+  /// std::runtime_error on main once the watchdog fired. Returns the
+  /// sim-time duration consumed by the step (0 in child threads).
+  duration_t update() {
+    if (m_step_flags.load(std::memory_order_relaxed)) [[unlikely]]
+      return update_slow();
+    return step_and_watch();
+  }
+
+  /*set timout relative to NOW */
+  void set_sim_timeout(duration_t timeout) {
+    sim_timeout = self().get_now() + timeout;
+  }
 
   duration_t run(duration_t run_time) {
     duration_t total(0);
@@ -305,6 +878,19 @@ protected:
     return total;
   }
 
+  /// Run until watch fires, or not at all if it is an EQUALS watch that
+  /// already holds. Returns the sim time run: the step the signal changed in
+  /// is the last one, so the wake-up time is exact.
+  duration_t run_until(signal_watch watch) {
+    duration_t total(0);
+    if (watch.holds())
+      return total;
+    do {
+      total += update();
+    } while (!watch.check());
+    return total;
+  }
+
   template <typename pin_t> duration_t run_until_rising_edge(pin_t &clock_pin) {
     duration_t total(0);
     while (clock_pin != 0) {
@@ -315,6 +901,89 @@ protected:
     }
     return total;
   }
+
+  /**
+   * \brief Run the test once, or serve it from a warm model.
+   *
+   * `setup` takes the freshly built model to the state every run starts from,
+   *typically the reset sequence, and `job` is one run of the test: it reads
+   *its parameters with get_cmd_line_arg() and throws on failure. Normally
+   *each is called once.
+   *
+   * With server=PATH on the command line the jobs come from the unix socket
+   *PATH instead, see job_server. Each job line holds key=value arguments
+   *that override the command line for that job. The driver saves its state
+   *once and returns to it before every job: after setup when derived_t has
+   *STATE_SNAPSHOT, otherwise at time 0, replaying setup for each job.
+   *Clocks go back to their saved state too and watches added by a job are
+   *removed after it, so callbacks, BFMs and other per-run state must be
+   *created by `job`. Every job gets the sim-time budget of the saved state
+   *and the wall_timeout budget afresh; a job running out of either fails,
+   *and the server carries on with the next one. Tests calling run_jobs()
+   *include job_server.hpp.
+   **/
+  template <typename setup_t, typename job_t, typename server_t = job_server>
+  void run_jobs(setup_t setup, job_t job) {
+    std::string path = get_cmd_line_arg("server");
+    if (path.empty()) {
+      setup();
+      job();
+      return;
+    }
+    except_assert2(!(m_step_flags.load() & STEP_THREADED),
+                   "server mode does not support add_thread()");
+    if constexpr (derived_t::STATE_SNAPSHOT)
+      setup();
+    self().save_state();
+    duration_t sim_budget = sim_timeout;
+    auto wall_timeout = get_wall_timeout();
+    // no budget while waiting for a job
+    reset_watchdog();
+
+    server_t server(path);
+    printf("serving jobs on %s\n", path.c_str());
+    fflush(stdout);
+    auto args = cmd_line_args;
+    size_t first_job_watch = m_next_watch_id;
+    std::string line;
+    while (server.next(line)) {
+      cmd_line_args = args;
+      std::istringstream tokens(line);
+      for (std::string arg; tokens >> arg;) {
+        auto eq = arg.find('=');
+        if (eq != std::string::npos)
+          cmd_line_args[arg.substr(0, eq)] = arg.substr(eq + 1);
+      }
+      auto start = std::chrono::steady_clock::now();
+      bool passed = true;
+      std::string failure;
+      try {
+        self().restore_state();
+        arm_watches();
+        sim_timeout = sim_budget;
+        set_wall_timeout(wall_timeout);
+        if constexpr (!derived_t::STATE_SNAPSHOT)
+          setup();
+        job();
+        // a budget that ran out in the job's last step
+        check_watchdog();
+      } catch (std::exception &e) {
+        passed = false;
+        failure = e.what();
+      }
+      // watches added by the job go with it
+      std::erase_if(m_watches, [first_job_watch](auto &w) {
+        return w.id >= first_job_watch;
+      });
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::string seconds = std::to_string(elapsed.count());
+      reset_watchdog();
+      server.reply(passed ? "PASS " + seconds
+                          : "FAIL " + seconds + " " + failure);
+    }
+    cmd_line_args = args;
+  }
 };
 
 #endif // SIM_DRIVER_HPP
@@ -1,14 +1,155 @@
 find_package(verilator 5.018 HINTS $ENV{VERILATOR_ROOT})
 
+set(VERILATOR_SHARED_RUNTIME Y CACHE BOOL "Build the Verilator runtime (verilated.cpp, trace writers, ...) once for all models instead of into every model library")
+set(VERILATOR_CCACHE N CACHE BOOL "Compile the verilated C++ through ccache, which hits whenever re-verilating produced the same code")
+set(VERILATOR_UNITY_BUILD N CACHE BOOL "Compile each model's generated C++ as a few unity sources")
+set(VERILATOR_JOBS "" CACHE STRING "Threads verilator itself may use per model (-j), empty for verilator's default")
+
+# Trace options shared by every verilated model. With TRACE_THREADS > 0 the
+# model's dump() only copies the changed values into a buffer and verilator's
+# own writer threads compress and write the FST file in the background.
+set(VERILATOR_TRACE_ARGS TRACE_FST TRACE_STRUCT)
+if(TRACE_THREADS)
+  list(APPEND VERILATOR_TRACE_ARGS TRACE_THREADS ${TRACE_THREADS})
+endif()
+
+# Scopes in TRACE_EXCLUDE are left out of the model's trace code entirely
+# (tracing_off in a verilator configuration file), unlike the trace_scope and
+# trace_depth run time arguments, which only select what is dumped.
+set(VERILATOR_TRACE_CONFIG)
+if(TRACE_EXCLUDE)
+  set(VERILATOR_TRACE_CONFIG ${CMAKE_BINARY_DIR}/trace_exclude.vlt)
+  set(vlt "`verilator_config\n")
+  foreach(scope ${TRACE_EXCLUDE})
+    string(APPEND vlt "tracing_off -scope \"${scope}\"\n")
+  endforeach()
+  # rewritten only when it changes, every model depends on it
+  file(CONFIGURE OUTPUT ${VERILATOR_TRACE_CONFIG} CONTENT "${vlt}" @ONLY)
+endif()
+
+set(VERILATOR_BUILD_ARGS)
+if(NOT VERILATOR_JOBS STREQUAL "")
+  list(APPEND VERILATOR_BUILD_ARGS -j ${VERILATOR_JOBS})
+endif()
+if(VERILATOR_CCACHE)
+  find_program(CCACHE_PROGRAM ccache REQUIRED)
+endif()
+
+# The runtime shared by every model: verilated like a model with the same
+# trace options, from an empty module, so that it gets exactly the runtime
+# sources and compile settings verilate() gives a model. --timing pulls in
+# the coroutine runtime for the models that need it.
+if(VERILATOR_SHARED_RUNTIME)
+  set(runtime_sv ${CMAKE_BINARY_DIR}/verilated_runtime.sv)
+  file(CONFIGURE OUTPUT ${runtime_sv} CONTENT "module verilated_runtime;\nendmodule\n" @ONLY)
+  add_library(verilated_runtime EXCLUDE_FROM_ALL STATIC)
+  verilate(verilated_runtime SOURCES ${runtime_sv}
+    ${VERILATOR_TRACE_ARGS}
+    VERILATOR_ARGS --timing ${VERILATOR_BUILD_ARGS}
+  )
+  target_compile_options(verilated_runtime PUBLIC -Wno-sign-compare)
+  if(VERILATOR_CCACHE)
+    set_property(TARGET verilated_runtime PROPERTY CXX_COMPILER_LAUNCHER ${CCACHE_PROGRAM})
+  endif()
+endif()
+
+# Build settings of every model library: drop the runtime sources verilate()
+# added that verilated_runtime already compiles, ccache and unity builds.
+# Runtime sources only some models need (verilated_save.cpp for --savable,
+# verilated_vpi.cpp for --vpi) stay in those models' libraries. Deferred to
+# the end of the directory, since verilate() may be called on the library
+# more than once (see csrc/CMakeLists.txt).
+function(verilator_model_settings name)
+  if(VERILATOR_SHARED_RUNTIME)
+    get_target_property(shared verilated_runtime SOURCES)
+    list(FILTER shared INCLUDE REGEX "/verilated[a-z_]*\\.cpp$")
+    get_target_property(sources ${name} SOURCES)
+    list(REMOVE_ITEM sources ${shared})
+    set_property(TARGET ${name} PROPERTY SOURCES ${sources})
+    target_link_libraries(${name} PUBLIC verilated_runtime)
+  endif()
+  if(VERILATOR_CCACHE)
+    set_property(TARGET ${name} PROPERTY CXX_COMPILER_LAUNCHER ${CCACHE_PROGRAM})
+  endif()
+  if(VERILATOR_UNITY_BUILD)
+    # verilator's own makefiles can build a model as one source too
+    set_property(TARGET ${name} PROPERTY UNITY_BUILD ON)
+  endif()
+endfunction()
+
+# Any arguments after source are passed to verilator, e.g. -GL2DEPTH=4,
+# except PROBES module.signal... which makes those signals public for
+# verilator_driver::probe(), in every instance of the module, and SOURCES
+# file... for modules instantiated by source.
 function(add_verilator_library name source)
+  cmake_parse_arguments(MRvl "" "" "PROBES;SOURCES" ${ARGN})
   add_library(${name} EXCLUDE_FROM_ALL STATIC)
-  verilate(${name} SOURCES ${source}
-    TRACE_FST TRACE_STRUCT
-    VERILATOR_ARGS --timing
+  set(probe_config)
+  if(MRvl_PROBES)
+    set(probe_config ${CMAKE_CURRENT_BINARY_DIR}/${name}_probes.vlt)
+    set(vlt "`verilator_config\n")
+    foreach(probe ${MRvl_PROBES})
+      string(REGEX MATCH "^([^.]+)\\.(.+)$" match ${probe})
+      if(NOT match)
+        message(FATAL_ERROR "PROBES takes module.signal, not ${probe}")
+      endif()
+      string(APPEND vlt "public_flat_rd -module \"${CMAKE_MATCH_1}\" -var \"${CMAKE_MATCH_2}\"\n")
+    endforeach()
+    file(CONFIGURE OUTPUT ${probe_config} CONTENT "${vlt}" @ONLY)
+    # --vpi so that the scope tables list the public signals
+    list(APPEND MRvl_UNPARSED_ARGUMENTS --vpi)
+  endif()
+  # verilate() names the model after its first source, which is one of the
+  # configuration files with PROBES or TRACE_EXCLUDE
+  get_filename_component(top ${source} NAME_WE)
+  verilate(${name} SOURCES ${VERILATOR_TRACE_CONFIG} ${probe_config} ${source}
+    ${MRvl_SOURCES} PREFIX V${top}
+    ${VERILATOR_TRACE_ARGS}
+    VERILATOR_ARGS --timing ${VERILATOR_BUILD_ARGS} ${MRvl_UNPARSED_ARGUMENTS}
   )
   target_include_directories(${name} PUBLIC ${CMAKE_CURRENT_FUNCTION_LIST_DIR})
   # Verilator's installed headers (verilated_funcs.h, verilated_types.h)
   # contain int-vs-size_t comparisons that trip -Wsign-compare under -Werror.
   # Suppress the warning for any consumer that links this library.
   target_compile_options(${name} PUBLIC -Wno-sign-compare)
+  # arguments of a deferred call are expanded when it runs, hence the EVAL
+  cmake_language(EVAL CODE
+    "cmake_language(DEFER CALL verilator_model_settings [[${name}]])")
+endfunction()
+
+# Verilate LANES independent copies of TOPLEVEL as one model, so that one
+# eval() advances all of them. The wrapper is generated by gen_lanes.py: every
+# port of TOPLEVEL becomes an unpacked array indexed by lane (dut->port[lane])
+# except the SHARED ones. The model is V<TOPLEVEL>_lanes.
+function(add_verilator_lanes_library name)
+  cmake_parse_arguments(MRlanes ""
+    "TOPLEVEL;SOURCE;LANES"
+    "SHARED;VERILATOR_ARGS"
+    ${ARGN})
+  find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+  get_filename_component(source ${MRlanes_SOURCE} ABSOLUTE)
+  set(script ${CMAKE_CURRENT_FUNCTION_LIST_DIR}/gen_lanes.py)
+  set(wrapper ${CMAKE_CURRENT_BINARY_DIR}/${MRlanes_TOPLEVEL}_lanes.sv)
+  list(JOIN MRlanes_SHARED "," shared)
+  # generated at configure time since verilate() needs its sources up front
+  execute_process(
+    COMMAND ${Python3_EXECUTABLE} ${script} --module ${MRlanes_TOPLEVEL}
+      --shared "${shared}" ${source} ${wrapper}
+    COMMAND_ERROR_IS_FATAL ANY)
+  set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${script} ${source})
+
+  add_library(${name} EXCLUDE_FROM_ALL STATIC)
+  verilate(${name} SOURCES ${VERILATOR_TRACE_CONFIG} ${wrapper} ${source}
+    TOP_MODULE ${MRlanes_TOPLEVEL}_lanes
+    PREFIX V${MRlanes_TOPLEVEL}_lanes
+    ${VERILATOR_TRACE_ARGS}
+    VERILATOR_ARGS --timing -GLANES=${MRlanes_LANES} ${VERILATOR_BUILD_ARGS}
+      ${MRlanes_VERILATOR_ARGS}
+  )
+  target_include_directories(${name} PUBLIC ${CMAKE_CURRENT_FUNCTION_LIST_DIR})
+  target_compile_definitions(${name} PUBLIC ${MRlanes_TOPLEVEL}_LANES=${MRlanes_LANES})
+  target_compile_options(${name} PUBLIC -Wno-sign-compare)
+  cmake_language(EVAL CODE
+    "cmake_language(DEFER CALL verilator_model_settings [[${name}]])")
 endfunction()
@@ -20,28 +20,254 @@
 
 #ifndef VERILATOR_DRIVER_HPP
 #define VERILATOR_DRIVER_HPP
+#include "port_view.hpp"
+#include "probe.hpp"
 #include "sim_driver.hpp"
 #include "verilated.h"
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <unistd.h>
+#include <vector>
 #include <verilated_fst_c.h>
-template <typename dut_t> class verilator_driver : protected sim_driver {
+#include <verilated_save.h>
+#include <verilated_syms.h>
+
+/// port_view of a port wider than 64 bits, N 32 bit words
+template <std::size_t N>
+class port_view<VlWide<N>> : public port_words<EData, N> {
+public:
+  explicit port_view(VlWide<N> &port) : port_words<EData, N>(port.data()) {}
+};
+
+template <typename dut_t>
+class verilator_driver : protected sim_driver<verilator_driver<dut_t>> {
   using duration_t = ClockDriver::duration_t;
+  using base_t = sim_driver<verilator_driver>;
+  friend base_t;
+  using base_t::m_clocks;
+  using base_t::parse_cmd_line_args;
+  using base_t::restore_clocks;
+  using base_t::save_clocks;
+  using base_t::shutdown;
+  using base_t::sim_timeout;
+  using base_t::trace_depth;
+  using base_t::trace_scopes;
+
+  /// A model added with add_model(), simulated next to dut
+  struct model_base {
+    virtual ~model_base() = default;
+    virtual void eval() = 0;
+    virtual bool eventsPending() = 0;
+    virtual uint64_t nextTimeSlot() = 0;
+    virtual void final() = 0;
+    virtual void trace(VerilatedFstC *tfp) = 0;
+    virtual void save(VerilatedSave &os) = 0;
+    virtual void restore(VerilatedRestore &is) = 0;
+  };
+  template <typename model_t> struct model_holder : model_base {
+    model_t *model;
+    model_holder(model_t *model) : model(model) {}
+    ~model_holder() { delete model; }
+    void eval() { model->eval(); }
+    bool eventsPending() { return model->eventsPending(); }
+    uint64_t nextTimeSlot() { return model->nextTimeSlot(); }
+    void final() { model->final(); }
+    void trace(VerilatedFstC *tfp) { model->trace(tfp, 99); }
+    void save(VerilatedSave &os) { save_model(os, *model); }
+    void restore(VerilatedRestore &is) { restore_model(is, *model); }
+  };
+
+  /// models verilated with --savable can be saved and restored
+  template <typename model_t>
+  static constexpr bool savable =
+      requires(VerilatedSerialize &os, model_t &m) { os << m; };
+  template <typename model_t>
+  static void save_model(VerilatedSave &os, model_t &m) {
+    if constexpr (savable<model_t>) {
+      os << m;
+    } else {
+      throw std::runtime_error("model not verilated with --savable");
+    }
+  }
+  template <typename model_t>
+  static void restore_model(VerilatedRestore &is, model_t &m) {
+    if constexpr (savable<model_t>) {
+      is >> m;
+    } else {
+      throw std::runtime_error("model not verilated with --savable");
+    }
+  }
+  static constexpr int MAX_SETTLE = 100;
 
   VerilatedContext *m_context;
   VerilatedFstC *m_trace;
-  duration_t sim_timeout;
+  std::string m_waveform_file;
+  std::vector<model_base *> m_models;
+  std::vector<std::function<bool()>> m_connections;
+  // see save_state()
+  std::string m_state_file;
+  uint64_t m_saved_time = 0;
+
+  /// copy every connection, true if any destination changed
+  bool propagate() {
+    bool changed = false;
+    for (auto &c : m_connections) {
+      changed |= c();
+    }
+    return changed;
+  }
+
+  /// Evaluate dut and the added models until the connections between them
+  /// are stable. Connections are copied once before any model evaluates, so
+  /// a clock connected from one model to another reaches every model before
+  /// the first one reacts to the edge.
+  void eval_models() {
+    if (m_models.empty()) {
+      dut->eval();
+      return;
+    }
+    propagate();
+    for (int i = 0;; ++i) {
+      dut->eval();
+      for (auto m : m_models) {
+        m->eval();
+      }
+      if (!propagate())
+        return;
+      if (i == MAX_SETTLE)
+        throw std::runtime_error(
+            "model connections did not settle, combinational loop?");
+    }
+  }
+
+  /// Opened by start(), so the test constructor can still add trace scopes
+  void open_trace() {
+    m_trace = new VerilatedFstC;
+    // dumpvars() level 0 would mean "everything", so unlimited is 99 levels
+    for (auto &scope : trace_scopes) {
+      int depth = scope.depth ? scope.depth : trace_depth;
+      m_trace->dumpvars(depth ? depth : 99, scope.hier);
+    }
+    if (trace_scopes.empty() && trace_depth) {
+      m_trace->dumpvars(trace_depth, "TOP");
+    }
+    dut->trace(m_trace, 99);
+    for (auto m : m_models) {
+      m->trace(m_trace);
+    }
+    m_trace->open(m_waveform_file.c_str());
+  }
 
 protected:
   dut_t *dut;
-  /*set timout relative to NOW */
-  void set_sim_timeout(duration_t timeout) {
-    sim_timeout = get_now() + timeout;
+
+  /**
+   * \brief Add another verilated model to the simulation. It shares the
+   *VerilatedContext (and so the time base), the clocks and the waveform file
+   *with dut, and is owned by the driver. Each model needs a unique name, which
+   *is also its scope in the waveform. Must be called before the first step.
+   **/
+  template <typename model_t> model_t *add_model(const char *name) {
+    auto h = new model_holder<model_t>(new model_t(m_context, name));
+    m_models.push_back(h);
+    return h->model;
   }
+
+  /**
+   * \brief Wire a port of one model to a port of another: dst follows src
+   *every step. To put several models in one clock domain, drive the clock of
+   *one with add_clock() and connect it to the others.
+   **/
+  template <typename src_t, typename dst_t>
+  void connect(const src_t &src, dst_t &dst) {
+    m_connections.push_back([&src, &dst] {
+      dst_t v = dst_t(src);
+      if (dst == v)
+        return false;
+      dst = v;
+      return true;
+    });
+  }
+
+  /**
+   * \brief Read access to a signal anywhere in the design by its name in the
+   *waveform, e.g. probe<CData>("TOP.dc_fifo.sim_used"). The name is looked up
+   *once in the scope tables of the model, which only list signals made public
+   *with add_verilator_library(... PROBES dc_fifo.sim_used). T is the type
+   *Verilator stores the signal in: CData, SData, IData or QData up to 8, 16,
+   *32 and 64 bits, VlWide<N> above. Throws if the signal is not found.
+   **/
+  template <typename T> probe_ref<T> probe(const std::string &name) {
+    auto dot = name.rfind('.');
+    except_assert2(dot != std::string::npos, "probe needs a scope: " + name);
+    const VerilatedScope *scope =
+        m_context->scopeFind(name.substr(0, dot).c_str());
+    except_assert2(scope, "no scope for probe " + name);
+    VerilatedVar *var = scope->varFind(name.substr(dot + 1).c_str());
+    except_assert2(var, "probe " + name +
+                            " not found, is it in the PROBES of its model?");
+    except_assert2(var->udims() == 0 && var->entSize() == sizeof(T),
+                   "probe " + name + " is not stored as the requested type");
+    return probe_ref<T>(static_cast<const T *>(var->datap()));
+  }
+
+  /// Models built with --savable can return to a saved state, see run_jobs()
+  static constexpr bool STATE_SNAPSHOT = savable<dut_t>;
+  /**
+   * \brief Save the state of every model, the time and the clocks, for
+   *restore_state(). The models must be verilated with --savable.
+   **/
+  void save_state() {
+    if constexpr (STATE_SNAPSHOT) {
+      except_assert2(m_waveform_file.empty(),
+                     "can not write a waveform across restore_state()");
+      if (m_state_file.empty()) {
+        // unique per driver, several may save in one process
+        std::string path = (std::filesystem::temp_directory_path() /
+                            "verilator_state_XXXXXX")
+                               .string();
+        int fd = mkstemp(path.data());
+        if (fd < 0) {
+          throw std::runtime_error("can not create the state file " + path);
+        }
+        close(fd);
+        m_state_file = path;
+      }
+      VerilatedSave os;
+      os.open(m_state_file.c_str());
+      save_model(os, *dut);
+      for (auto m : m_models) {
+        m->save(os);
+      }
+      os.close();
+      m_saved_time = m_context->time();
+      save_clocks();
+    } else {
+      throw std::runtime_error("saving the state needs a model verilated "
+                               "with --savable");
+    }
+  }
+  void restore_state() {
+    if constexpr (STATE_SNAPSHOT) {
+      VerilatedRestore is;
+      is.open(m_state_file.c_str());
+      restore_model(is, *dut);
+      for (auto m : m_models) {
+        m->restore(is);
+      }
+      is.close();
+      m_context->time(m_saved_time);
+      restore_clocks();
+    }
+  }
+
   verilator_driver(int argc, char **argv) {
-    std::string waveform_file = parse_cmd_line_args(argc, argv);
+    m_waveform_file = parse_cmd_line_args(argc, argv);
 
     m_context = new VerilatedContext;
     m_context->commandArgs(argc, argv);
-    if (waveform_file != "") {
+    if (m_waveform_file != "") {
       m_context->traceEverOn(true);
     }
 
@@ -50,25 +276,33 @@ protected:
     m_context->timeunit(12);
     m_context->timeprecision(12);
 
-    if (waveform_file != "") {
-      m_trace = new VerilatedFstC;
-      dut->trace(m_trace, 99);
-      m_trace->open(waveform_file.c_str());
-    } else {
-      m_trace = NULL;
-    }
+    m_trace = NULL;
     sim_timeout = std::chrono::milliseconds(10);
   }
   ~verilator_driver() {
     shutdown();
     dut->final();
+    for (auto m : m_models) {
+      m->final();
+    }
     delete m_trace;
+    for (auto m : m_models) {
+      delete m;
+    }
     delete dut;
     delete m_context;
+    if (!m_state_file.empty()) {
+      std::filesystem::remove(m_state_file);
+    }
   }
   duration_t get_now() { return duration_t(m_context->time()); }
+  void start() {
+    if (!m_waveform_file.empty()) {
+      open_trace();
+    }
+  }
   duration_t _update() {
-    dut->eval();
+    eval_models();
     if (m_trace) {
       m_trace->dump(m_context->time());
     }
@@ -77,6 +311,10 @@ protected:
     if (dut->eventsPending()) {
       min_update = duration_t(dut->nextTimeSlot());
     }
+    for (auto m : m_models) {
+      if (m->eventsPending() && duration_t(m->nextTimeSlot()) < min_update)
+        min_update = duration_t(m->nextTimeSlot());
+    }
     for (auto &cd : m_clocks) {
       auto x = cd.next_update();
       if (x < min_update)
@@ -91,17 +329,13 @@ protected:
         cd.update(now);
       }
     }
-    dut->eval();
+    eval_models();
     for (auto &cd : m_clocks) {
       if (cd.last_update() == now) {
         cd.exec_callbacks();
       }
     }
 
-    if (sim_timeout != std::chrono::milliseconds(0) && now >= sim_timeout) {
-      throw std::runtime_error("Simulation timed out\n");
-    }
-
     return get_now() - start;
   }
 };
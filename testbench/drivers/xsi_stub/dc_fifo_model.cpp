@@ -0,0 +1,179 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+/*
+ * Behavioural stub model of rtl/dc_fifo.sv with T=logic [15:0], or
+ * logic [DC_FIFO_MODEL_WIDTH-1:0] (see dc_fifo_wide_model.cpp). L2DEPTH, FWFT
+ * and OUT_REG default to the RTL defaults and can be overridden with
+ * `-generic_top` in the ELAB_ARGS of add_xsim_library(), which xsi_stub.cmake
+ * passes on as XSI_GENERIC_<name>. Register names follow the RTL, including
+ * the cc_gray pointer synchronizers, so the cycle timing of
+ * wr_full/rd_empty/usedw matches the verilated model.
+ */
+
+#include "xsi_stub.hpp"
+#include <array>
+
+#ifndef DC_FIFO_MODEL_WIDTH
+#define DC_FIFO_MODEL_WIDTH 16
+#endif
+
+#ifndef XSI_GENERIC_L2DEPTH
+#define XSI_GENERIC_L2DEPTH 3
+#endif
+#ifndef XSI_GENERIC_FWFT
+#define XSI_GENERIC_FWFT 0
+#endif
+#ifndef XSI_GENERIC_OUT_REG
+#define XSI_GENERIC_OUT_REG 0
+#endif
+
+namespace {
+class dc_fifo_model : public xsi_stub_design {
+  static constexpr int WIDTH = DC_FIFO_MODEL_WIDTH;
+  static constexpr int NWORDS = (WIDTH + 31) / 32;
+  static constexpr int L2DEPTH = XSI_GENERIC_L2DEPTH;
+  static constexpr bool FWFT = XSI_GENERIC_FWFT;
+  static constexpr bool OUT_REG = XSI_GENERIC_OUT_REG;
+  static constexpr uint64_t PTR_MASK = (1 << L2DEPTH) - 1;
+  static_assert(!(FWFT && OUT_REG), "FWFT and OUT_REG are incompatible");
+
+  int wr_clk, wr_rstn, wr_din, wr_write, wr_full, wr_usedw;
+  int rd_clk, rd_rstn, rd_read, rd_dout, rd_empty, rd_usedw;
+  edge_detect wr_clk_edge, rd_clk_edge;
+
+  struct cc_gray {
+    uint64_t ff_gray = 0, ff_gray_out0 = 0, ff_gray_out1 = 0, ff_bin_out = 0;
+  };
+  using data_t = std::array<s_xsi_vlog_logicval, NWORDS>;
+  struct state_t {
+    std::array<data_t, 1 << L2DEPTH> ram{};
+    uint64_t w_wptr = 0, w_wptr_plus1 = 0, w_wptr_plus2 = 0;
+    uint64_t r_rptr = 0, r_rptr_plus1 = 0;
+    uint64_t wr_full = 0, wr_usedw = 0;
+    uint64_t rd_empty = 0, rd_usedw = 0;
+    data_t rd_data{}, rd_dout{};
+    cc_gray cc_wptr, cc_rptr;
+  } s;
+
+  static uint64_t bin2gray(uint64_t v) { return v ^ (v >> 1); }
+  static uint64_t gray2bin(uint64_t v) {
+    for (int shift = 1; shift < L2DEPTH; shift <<= 1)
+      v ^= v >> shift;
+    return v;
+  }
+  static void cc_in(cc_gray &n, uint64_t in) {
+    n.ff_gray = bin2gray(in);
+  }
+  static void cc_out(const cc_gray &o, cc_gray &n) {
+    n.ff_gray_out0 = o.ff_gray;
+    n.ff_gray_out1 = o.ff_gray_out0;
+    n.ff_bin_out = gray2bin(o.ff_gray_out1);
+  }
+
+  void wr_edge(const state_t &o, state_t &n) {
+    uint64_t w_rptr = o.cc_rptr.ff_bin_out;
+    bool wr_prot = get(wr_write) && !o.wr_full;
+    n.wr_full = ((o.w_wptr_plus1 ^ w_rptr) & PTR_MASK) == 0;
+    n.wr_usedw = (o.w_wptr - w_rptr) & PTR_MASK;
+    if (wr_prot) {
+      std::copy_n(get_words(wr_din), NWORDS, n.ram[o.w_wptr].begin());
+      n.w_wptr_plus2 = (o.w_wptr_plus2 + 1) & PTR_MASK;
+      n.w_wptr_plus1 = o.w_wptr_plus2;
+      n.w_wptr = o.w_wptr_plus1;
+      n.wr_usedw = (o.w_wptr_plus1 - w_rptr) & PTR_MASK;
+      if (o.w_wptr_plus2 == w_rptr)
+        n.wr_full = 1;
+    }
+    if (!get(wr_rstn)) {
+      n.w_wptr = 0;
+      n.w_wptr_plus1 = 1;
+      n.w_wptr_plus2 = 2;
+    }
+    cc_in(n.cc_wptr, o.w_wptr);
+    cc_out(o.cc_rptr, n.cc_rptr);
+  }
+
+  void rd_edge(const state_t &o, state_t &n) {
+    uint64_t r_wptr = o.cc_wptr.ff_bin_out;
+    bool rd_prot = get(rd_read) && !o.rd_empty;
+    if (FWFT || get(rd_read))
+      n.rd_data = o.ram[o.r_rptr];
+    n.rd_empty = o.r_rptr == r_wptr;
+    n.rd_usedw = (r_wptr - o.r_rptr) & PTR_MASK;
+    if (rd_prot) {
+      if (o.r_rptr_plus1 == r_wptr) {
+        n.rd_empty = 1;
+        n.rd_usedw = (r_wptr - o.r_rptr_plus1) & PTR_MASK;
+      }
+      if (FWFT)
+        n.rd_data = o.ram[o.r_rptr_plus1];
+      n.r_rptr = o.r_rptr_plus1;
+      n.r_rptr_plus1 = (o.r_rptr_plus1 + 1) & PTR_MASK;
+    }
+    if (OUT_REG)
+      n.rd_dout = o.rd_data;
+    if (!get(rd_rstn)) {
+      n.r_rptr = 0;
+      n.r_rptr_plus1 = 1;
+    }
+    cc_in(n.cc_rptr, o.r_rptr);
+    cc_out(o.cc_wptr, n.cc_wptr);
+  }
+
+public:
+  dc_fifo_model() {
+    wr_clk = add_port("wr_clk", xsiInputPort, 1);
+    wr_rstn = add_port("wr_rstn", xsiInputPort, 1);
+    wr_din = add_port("wr_din", xsiInputPort, WIDTH);
+    wr_write = add_port("wr_write", xsiInputPort, 1);
+    wr_full = add_port("wr_full", xsiOutputPort, 1);
+    wr_usedw = add_port("wr_usedw", xsiOutputPort, L2DEPTH);
+    rd_clk = add_port("rd_clk", xsiInputPort, 1);
+    rd_rstn = add_port("rd_rstn", xsiInputPort, 1);
+    rd_read = add_port("rd_read", xsiInputPort, 1);
+    rd_dout = add_port("rd_dout", xsiOutputPort, WIDTH);
+    rd_empty = add_port("rd_empty", xsiOutputPort, 1);
+    rd_usedw = add_port("rd_usedw", xsiOutputPort, L2DEPTH);
+  }
+
+  void eval() override {
+    bool wr_rise = wr_clk_edge.rising(get(wr_clk));
+    bool rd_rise = rd_clk_edge.rising(get(rd_clk));
+    if (!wr_rise && !rd_rise)
+      return;
+    // nonblocking assignment semantics: every always_ff reads the state from
+    // before the edge
+    state_t n = s;
+    if (wr_rise)
+      wr_edge(s, n);
+    if (rd_rise)
+      rd_edge(s, n);
+    s = n;
+    set(wr_full, s.wr_full);
+    set(wr_usedw, s.wr_usedw);
+    set_words(rd_dout, (OUT_REG ? s.rd_dout : s.rd_data).data());
+    set(rd_empty, s.rd_empty);
+    set(rd_usedw, s.rd_usedw);
+  }
+};
+} // namespace
+
+xsi_stub_design *xsi_stub_create_design() { return new dc_fifo_model; }
@@ -0,0 +1,77 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+/*
+ * Behavioural stub model of rtl/dc_ram.sv with the default parameters
+ * (DATA_WIDTH=8, ADDR_WIDTH=6).
+ */
+
+#include "xsi_stub.hpp"
+#include <array>
+
+namespace {
+class dc_ram_model : public xsi_stub_design {
+  static constexpr int DATA_WIDTH = 8;
+  static constexpr int ADDR_WIDTH = 6;
+
+  int data_a, data_b, addr_a, addr_b, we_a, we_b, clk_a, clk_b, q_a, q_b;
+  edge_detect clk_a_edge, clk_b_edge;
+  std::array<uint64_t, 1 << ADDR_WIDTH> ram{};
+
+public:
+  dc_ram_model() {
+    data_a = add_port("data_a", xsiInputPort, DATA_WIDTH);
+    data_b = add_port("data_b", xsiInputPort, DATA_WIDTH);
+    addr_a = add_port("addr_a", xsiInputPort, ADDR_WIDTH);
+    addr_b = add_port("addr_b", xsiInputPort, ADDR_WIDTH);
+    we_a = add_port("we_a", xsiInputPort, 1);
+    we_b = add_port("we_b", xsiInputPort, 1);
+    clk_a = add_port("clk_a", xsiInputPort, 1);
+    clk_b = add_port("clk_b", xsiInputPort, 1);
+    q_a = add_port("q_a", xsiOutputPort, DATA_WIDTH);
+    q_b = add_port("q_b", xsiOutputPort, DATA_WIDTH);
+  }
+
+  void eval() override {
+    bool rise_a = clk_a_edge.rising(get(clk_a));
+    bool rise_b = clk_b_edge.rising(get(clk_b));
+    // both ports sample the RAM contents from before this time step
+    auto old_ram = ram;
+    if (rise_a) {
+      if (get(we_a)) {
+        ram[get(addr_a)] = get(data_a);
+        set(q_a, get(data_a));
+      } else {
+        set(q_a, old_ram[get(addr_a)]);
+      }
+    }
+    if (rise_b) {
+      if (get(we_b)) {
+        ram[get(addr_b)] = get(data_b);
+        set(q_b, get(data_b));
+      } else {
+        set(q_b, old_ram[get(addr_b)]);
+      }
+    }
+  }
+};
+} // namespace
+
+xsi_stub_design *xsi_stub_create_design() { return new dc_ram_model; }
@@ -0,0 +1,85 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+/*
+ * Stand-in for the Vivado xsi.h header. Declares the subset of the XSI API
+ * used by xsim_driver.hpp and xsim_header_gen.cpp, with the same names,
+ * constants and struct layouts, so the xsim flow can be built against
+ * xsi_stub.cpp on machines without Vivado (cmake -DXSIM_STUB=Y).
+ */
+
+#ifndef XSI_STUB_XSI_H
+#define XSI_STUB_XSI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int XSI_INT32;
+typedef unsigned int XSI_UINT32;
+typedef long long XSI_INT64;
+
+typedef void *xsiHandle;
+
+typedef struct t_xsi_setup_info {
+  char *logFileName;
+  char *wdbFileName;
+  void *xsimDir;
+} s_xsi_setup_info, *p_xsi_setup_info;
+
+typedef struct t_xsi_vlog_logicval {
+  XSI_UINT32 aVal;
+  XSI_UINT32 bVal;
+} s_xsi_vlog_logicval, *p_xsi_vlog_logicval;
+
+/* xsi_get_int() properties */
+#define xsiNumTopPorts 1
+#define xsiTimePrecisionKernel 2
+/* xsi_get_int_port() properties */
+#define xsiDirectionTopPort 3
+#define xsiHDLValueSize 4
+
+/* port directions */
+#define xsiInputPort 1
+#define xsiOutputPort 2
+#define xsiInoutPort 3
+
+xsiHandle xsi_open(p_xsi_setup_info setup_info);
+void xsi_close(xsiHandle design_handle);
+void xsi_run(xsiHandle design_handle, XSI_INT64 time_ticks);
+void xsi_restart(xsiHandle design_handle);
+XSI_INT64 xsi_get_time(xsiHandle design_handle);
+int xsi_get_status(xsiHandle design_handle);
+const char *xsi_get_error_info(xsiHandle design_handle);
+void xsi_trace_all(xsiHandle design_handle);
+
+int xsi_get_int(xsiHandle design_handle, int property_type);
+int xsi_get_int_port(xsiHandle design_handle, int port_number,
+                     int property_type);
+int xsi_get_port_number(xsiHandle design_handle, const char *port_name);
+const char *xsi_get_port_name(xsiHandle design_handle, int port_number);
+void xsi_put_value(xsiHandle design_handle, int port_number, void *value);
+void xsi_get_value(xsiHandle design_handle, int port_number, void *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XSI_STUB_XSI_H
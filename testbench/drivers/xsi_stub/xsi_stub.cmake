@@ -0,0 +1,53 @@
+# Stub replacement for add_xsim_library(), used when XSIM_STUB is set.
+# Instead of elaborating the RTL with xvlog/xelab, the xsim library is built
+# from the stub XSI kernel (xsi_stub.cpp) and the behavioural model
+# <TOPLEVEL>_model.cpp in this directory. The dut header is still generated
+# by xsim_header_gen.cpp, so tests see the same interface as with vivado.
+# `-generic_top NAME=VALUE` in ELAB_ARGS is passed to the model as the
+# definition XSI_GENERIC_NAME=VALUE; other xelab arguments are ignored.
+
+function(add_xsim_library name)
+  cmake_parse_arguments(XSIMtest ""
+    "TOPLEVEL"
+    "VERILOG_SOURCES;SV_SOURCES;VLOG_ARGS;ELAB_ARGS"
+    ${ARGN})
+
+  if(NOT DEFINED XSIMtest_TOPLEVEL)
+    message(SEND_ERROR "TOPLEVEL ${XSIMtest_TOPLEVEL} must be defined")
+  endif()
+  set(model ${CMAKE_CURRENT_FUNCTION_LIST_DIR}/${XSIMtest_TOPLEVEL}_model.cpp)
+  if(NOT EXISTS ${model})
+    message(SEND_ERROR "No xsi stub model ${model} for ${XSIMtest_TOPLEVEL}")
+  endif()
+  set(sim_dir ${CMAKE_CURRENT_BINARY_DIR}/xsim.dir/${XSIMtest_TOPLEVEL})
+
+  add_library(${name}_xsim SHARED
+    ${CMAKE_CURRENT_FUNCTION_LIST_DIR}/xsi_stub.cpp ${model})
+  target_include_directories(${name}_xsim PUBLIC ${CMAKE_CURRENT_FUNCTION_LIST_DIR})
+  set_property(TARGET ${name}_xsim PROPERTY CXX_STANDARD 20)
+  set(generic_next OFF)
+  foreach(arg ${XSIMtest_ELAB_ARGS})
+    if(generic_next)
+      string(REPLACE "\"" "" arg ${arg})
+      target_compile_definitions(${name}_xsim PRIVATE XSI_GENERIC_${arg})
+    endif()
+    string(COMPARE EQUAL "${arg}" "-generic_top" generic_next)
+  endforeach()
+  set_target_properties(${name}_xsim PROPERTIES
+    LIBRARY_OUTPUT_DIRECTORY ${sim_dir})
+
+  add_executable(${name}_gen ${CMAKE_CURRENT_FUNCTION_LIST_DIR}/../xsim_header_gen.cpp)
+  target_link_libraries(${name}_gen PRIVATE ${name}_xsim)
+  add_custom_command(OUTPUT ${sim_dir}/${name}.hpp
+    DEPENDS ${name}_gen
+    COMMAND $<TARGET_FILE:${name}_gen> ${sim_dir}/${name}.hpp ${name})
+  add_custom_target(${name}_cst_tgt
+    DEPENDS ${sim_dir}/${name}.hpp)
+
+  add_library(${name} INTERFACE)
+  target_include_directories(${name} INTERFACE ${sim_dir} ${CMAKE_CURRENT_FUNCTION_LIST_DIR}/..)
+  target_link_libraries(${name} INTERFACE ${name}_xsim)
+  add_dependencies(${name}
+    ${name}_cst_tgt
+  )
+endfunction()
@@ -0,0 +1,137 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+/*
+ * Minimal stand-in for the Vivado XSI kernel (libxv_simulator_kernel +
+ * xsimk.so). Time advances only when xsi_run() is called and the linked
+ * behavioural model is evaluated once per call. Set XSI_STUB_STATS=1 in the
+ * environment to print the number of kernel calls on xsi_close().
+ */
+
+#include "xsi_stub.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace {
+struct stub_kernel {
+  std::unique_ptr<xsi_stub_design> design;
+  XSI_INT64 time = 0;
+  uint64_t n_run = 0, n_get = 0, n_put = 0;
+  std::string error;
+};
+
+stub_kernel *kernel(xsiHandle h) { return static_cast<stub_kernel *>(h); }
+} // namespace
+
+extern "C" {
+
+xsiHandle xsi_open(p_xsi_setup_info) {
+  auto k = new stub_kernel;
+  k->design.reset(xsi_stub_create_design());
+  return k;
+}
+
+void xsi_close(xsiHandle h) {
+  auto k = kernel(h);
+  const char *stats = getenv("XSI_STUB_STATS");
+  if (stats && stats[0] != '0') {
+    fprintf(stderr,
+            "xsi_stub: %llu xsi_run, %llu xsi_get_value, %llu xsi_put_value\n",
+            (unsigned long long)k->n_run, (unsigned long long)k->n_get,
+            (unsigned long long)k->n_put);
+  }
+  delete k;
+}
+
+void xsi_run(xsiHandle h, XSI_INT64 time_ticks) {
+  auto k = kernel(h);
+  k->n_run++;
+  k->time += time_ticks;
+  k->design->eval();
+}
+
+void xsi_restart(xsiHandle h) {
+  auto k = kernel(h);
+  k->design.reset(xsi_stub_create_design());
+  k->time = 0;
+}
+
+XSI_INT64 xsi_get_time(xsiHandle h) { return kernel(h)->time; }
+
+int xsi_get_status(xsiHandle h) { return kernel(h)->error.empty() ? 0 : 1; }
+
+const char *xsi_get_error_info(xsiHandle h) {
+  return kernel(h)->error.c_str();
+}
+
+void xsi_trace_all(xsiHandle) {
+  fprintf(stderr, "xsi_stub: waveform tracing is not supported\n");
+}
+
+int xsi_get_int(xsiHandle h, int property_type) {
+  switch (property_type) {
+  case xsiNumTopPorts:
+    return int(kernel(h)->design->ports.size());
+  case xsiTimePrecisionKernel:
+    return -12;
+  }
+  return -1;
+}
+
+int xsi_get_int_port(xsiHandle h, int port_number, int property_type) {
+  auto &port = kernel(h)->design->ports.at(port_number);
+  switch (property_type) {
+  case xsiDirectionTopPort:
+    return port.dir;
+  case xsiHDLValueSize:
+    return port.width;
+  }
+  return -1;
+}
+
+int xsi_get_port_number(xsiHandle h, const char *port_name) {
+  auto &ports = kernel(h)->design->ports;
+  for (unsigned p = 0; p < ports.size(); ++p) {
+    if (ports[p].name == port_name)
+      return int(p);
+  }
+  return -1;
+}
+
+const char *xsi_get_port_name(xsiHandle h, int port_number) {
+  return kernel(h)->design->ports.at(port_number).name.c_str();
+}
+
+void xsi_put_value(xsiHandle h, int port_number, void *value) {
+  auto k = kernel(h);
+  k->n_put++;
+  auto &val = k->design->ports.at(port_number).val;
+  memcpy(val.data(), value, val.size() * sizeof(s_xsi_vlog_logicval));
+}
+
+void xsi_get_value(xsiHandle h, int port_number, void *value) {
+  auto k = kernel(h);
+  k->n_get++;
+  auto &val = k->design->ports.at(port_number).val;
+  memcpy(value, val.data(), val.size() * sizeof(s_xsi_vlog_logicval));
+}
+}
@@ -0,0 +1,96 @@
+/**
+ * Copyright (2024) MicroRidge Technology LTD.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **/
+
+#ifndef XSI_STUB_HPP
+#define XSI_STUB_HPP
+#include "xsi.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Behavioural C++ model of a toplevel, loaded by the stub XSI kernel in
+ * place of an elaborated xsimk.so.
+ *
+ * A model declares its ports in the constructor (in the same order as the RTL
+ * port list, since that is the order xsim reports them in) and implements
+ * eval(), which the kernel calls at the end of every xsi_run(). Each stub
+ * library contains exactly one model, created by xsi_stub_create_design().
+ **/
+class xsi_stub_design {
+public:
+  struct port_t {
+    std::string name;
+    int dir;
+    int width;
+    std::vector<s_xsi_vlog_logicval> val;
+  };
+
+  virtual ~xsi_stub_design() = default;
+  virtual void eval() = 0;
+
+  std::vector<port_t> ports;
+
+protected:
+  int add_port(const char *name, int dir, int width) {
+    ports.push_back({name, dir, width,
+                     std::vector<s_xsi_vlog_logicval>((width + 31) / 32)});
+    return int(ports.size() - 1);
+  }
+  /// low 64 bits of a port
+  uint64_t get(int port) const {
+    auto &v = ports[port].val;
+    uint64_t r = v[0].aVal;
+    if (v.size() > 1)
+      r |= uint64_t(v[1].aVal) << 32;
+    return r;
+  }
+  void set(int port, uint64_t value) {
+    auto &v = ports[port].val;
+    for (unsigned i = 0; i < v.size(); ++i) {
+      v[i].aVal = i < 2 ? uint32_t(value >> (32 * i)) : 0;
+      v[i].bVal = 0;
+    }
+  }
+
+  /// all (width + 31) / 32 words of a port, LSW first
+  const s_xsi_vlog_logicval *get_words(int port) const {
+    return ports[port].val.data();
+  }
+  void set_words(int port, const s_xsi_vlog_logicval *words) {
+    auto &v = ports[port].val;
+    std::copy(words, words + v.size(), v.begin());
+  }
+
+  /// Rising edge detector for clock inputs, call once per eval()
+  struct edge_detect {
+    uint64_t last = 0;
+    bool rising(uint64_t v) {
+      bool r = v && !last;
+      last = v;
+      return r;
+    }
+  };
+};
+
+xsi_stub_design *xsi_stub_create_design();
+
+#endif // XSI_STUB_HPP
@@ -2,6 +2,11 @@ cmake_minimum_required(VERSION 3.22)
 
 project(MicroRidge_examples)
 
+if(XSIM_STUB)
+  include(${CMAKE_CURRENT_LIST_DIR}/xsi_stub/xsi_stub.cmake)
+  return()
+endif()
+
 find_program(VIVADO_BIN vivado
     PATHS  /tools/Xilinx/Vivado/2024.2/bin/ /opt/Xilinx/Vivado/2024.2/bin/
     REQUIRED
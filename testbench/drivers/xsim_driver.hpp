@@ -20,71 +20,337 @@
 
 #ifndef XSIM_DRIVER_HPP
 #define XSIM_DRIVER_HPP
+#include "port_view.hpp"
+#include "probe.hpp"
 #include "sim_driver.hpp"
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
+#include <string>
 #include <type_traits>
 #include <xsi.h>
 
-template <int WIDTH> class sim_port {
-  // create unsigne type at least WIDTH bits wide
-  using T = typename std::conditional<
-      WIDTH <= 8, uint8_t,
-      typename std::conditional<
-          WIDTH <= 16, uint16_t,
-          typename std::conditional<
-              WIDTH <= 32, uint32_t,
-              typename std::conditional<
-                  WIDTH <= 64, uint64_t,
-                  typename std::conditional<WIDTH <= 128, __uint128_t, void>::
-                      type>::type>::type>::type>::type;
-  xsiHandle xsi_handle;
+class sim_port_base;
+
+/**
+ * \brief Port state shared between an xsim_driver and the sim_ports of its
+ * dut.
+ *
+ * Port reads are served from a per-port cache that is valid until the next
+ * xsi_run() (tracked with the epoch counter) and port writes are deferred
+ * until flush(), which xsim_driver calls right before every xsi_run(). A test
+ * that polls the same outputs several times per step therefore only pays one
+ * xsi_get_value() per port per step, and only the last value written to an
+ * input in a step reaches the kernel.
+ **/
+class xsi_port_cache {
+  friend class sim_port_base;
+  xsiHandle m_handle;
+  uint64_t m_epoch = 1;
+  std::vector<sim_port_base *> m_inputs;
+
+public:
+  explicit xsi_port_cache(xsiHandle handle) : m_handle(handle) {}
+  xsiHandle handle() const { return m_handle; }
+  uint64_t epoch() const { return m_epoch; }
+  /// Push all deferred writes to the kernel
+  inline void flush();
+  /// Drop cached output values, call after every xsi_run()
+  void invalidate() { ++m_epoch; }
+  /// Forget every cached and deferred value, call after xsi_restart()
+  inline void restart();
+};
+
+class sim_port_base {
+  friend class xsi_port_cache;
+
+protected:
+  xsi_port_cache &m_cache;
   int port_num;
   std::string name;
-  T mask_val;
+  mutable uint64_t m_epoch = 0;
+  bool m_dirty = false;
+  s_xsi_vlog_logicval *m_words;
 
-public:
-  sim_port(xsiHandle handle, std::string name) {
-    this->xsi_handle = handle;
-    this->name = name;
-    this->port_num = xsi_get_port_number(handle, name.c_str());
+  sim_port_base(xsi_port_cache &cache, std::string name, int dir,
+                s_xsi_vlog_logicval *words)
+      : m_cache(cache), name(name), m_words(words) {
+    this->port_num = xsi_get_port_number(cache.handle(), name.c_str());
     if (port_num < 0) {
       fprintf(stderr, "ERROR: simulation port '%s' not found\n", name.c_str());
       exit(1);
     }
-    mask_val = (1UL << WIDTH) - 1;
+    if (dir != xsiOutputPort) {
+      cache.m_inputs.push_back(this);
+    }
+  }
+  sim_port_base(const sim_port_base &) = delete;
+  sim_port_base &operator=(const sim_port_base &) = delete;
+
+  void load() const {
+    xsi_get_value(m_cache.handle(), port_num, m_words);
+    m_epoch = m_cache.epoch();
+  }
+  void flush() {
+    xsi_put_value(m_cache.handle(), port_num, m_words);
+    m_dirty = false;
+  }
+};
+
+void xsi_port_cache::flush() {
+  for (auto p : m_inputs) {
+    if (p->m_dirty)
+      p->flush();
   }
+}
+
+void xsi_port_cache::restart() {
+  for (auto p : m_inputs) {
+    p->m_epoch = 0;
+    p->m_dirty = false;
+  }
+  invalidate();
+}
+
+/// Value type of a sim_port: the smallest unsigned integer holding WIDTH
+/// bits, or an array of 32 bit words (LSW first) for ports wider than 128 bits
+template <int WIDTH>
+using sim_port_value_t = typename std::conditional<
+    WIDTH <= 8, uint8_t,
+    typename std::conditional<
+        WIDTH <= 16, uint16_t,
+        typename std::conditional<
+            WIDTH <= 32, uint32_t,
+            typename std::conditional<
+                WIDTH <= 64, uint64_t,
+                typename std::conditional<
+                    WIDTH <= 128, __uint128_t,
+                    std::array<uint32_t, (WIDTH + 31) / 32>>::type>::type>::
+                type>::type>::type;
+
+template <int WIDTH, int DIR = xsiInoutPort>
+class sim_port : public sim_port_base {
+  using T = sim_port_value_t<WIDTH>;
+  static constexpr int NWORDS = (WIDTH + 31) / 32;
+  static constexpr uint32_t TOP_MASK =
+      WIDTH % 32 ? (uint32_t(1) << (WIDTH % 32)) - 1 : ~uint32_t(0);
+
+  mutable std::array<s_xsi_vlog_logicval, NWORDS> m_val{};
+
+  // inputs only change when we write them, so once read they stay valid
+  bool stale() const {
+    if constexpr (DIR == xsiInputPort) {
+      return m_epoch == 0;
+    } else {
+      return m_epoch != m_cache.epoch();
+    }
+  }
+
+public:
+  sim_port(xsi_port_cache &cache, std::string name)
+      : sim_port_base(cache, name, DIR, m_val.data()) {}
+
   void set_val(uint32_t aval, uint32_t bval) {
-    s_xsi_vlog_logicval vlog_val = {aval, bval};
-    xsi_put_value(xsi_handle, port_num, &vlog_val);
+    static_assert(DIR != xsiOutputPort, "can not drive an output port");
+    m_val = {};
+    m_val[0] = {aval, bval};
+    m_epoch = m_cache.epoch();
+    m_dirty = true;
   }
   s_xsi_vlog_logicval get_val() const {
-    s_xsi_vlog_logicval vlog_val = {0, 0};
-    xsi_get_value(xsi_handle, port_num, &vlog_val);
-    return vlog_val;
+    if (stale())
+      load();
+    return m_val[0];
+  }
+
+  /// copy the port value to/from NWORDS 32 bit words, LSW first
+  void read_words(uint32_t *words) const {
+    if (stale())
+      load();
+    for (int i = 0; i < NWORDS; ++i) {
+      words[i] = m_val[i].aVal & (i == NWORDS - 1 ? TOP_MASK : ~uint32_t(0));
+    }
+  }
+  void write_words(const uint32_t *words) {
+    static_assert(DIR != xsiOutputPort, "can not drive an output port");
+    if (!stale() && !m_dirty) {
+      // skip writes that would not change the kernel's value
+      bool same = true;
+      for (int i = 0; i < NWORDS; ++i) {
+        same &= m_val[i].bVal == 0 &&
+                m_val[i].aVal ==
+                    (words[i] & (i == NWORDS - 1 ? TOP_MASK : ~uint32_t(0)));
+      }
+      if (same)
+        return;
+    }
+    for (int i = 0; i < NWORDS; ++i) {
+      m_val[i].aVal = words[i] & (i == NWORDS - 1 ? TOP_MASK : ~uint32_t(0));
+      m_val[i].bVal = 0;
+    }
+    m_epoch = m_cache.epoch();
+    m_dirty = true;
   }
 
   const T &operator=(const T &setval) {
-    set_val(setval & mask_val, 0);
+    if constexpr (std::is_integral_v<T> || std::is_same_v<T, __uint128_t>) {
+      uint32_t words[NWORDS];
+      for (int i = 0; i < NWORDS; ++i) {
+        words[i] = uint32_t(setval >> (32 * i));
+      }
+      write_words(words);
+    } else {
+      write_words(setval.data());
+    }
     return setval;
   }
   operator T() const {
-    s_xsi_vlog_logicval v;
-    v = get_val();
-    return (T)(v.aVal & mask_val);
+    uint32_t words[NWORDS];
+    read_words(words);
+    if constexpr (std::is_integral_v<T> || std::is_same_v<T, __uint128_t>) {
+      T v = 0;
+      for (int i = 0; i < NWORDS; ++i) {
+        v |= T(words[i]) << (32 * i);
+      }
+      return v;
+    } else {
+      T v;
+      std::copy(words, words + NWORDS, v.begin());
+      return v;
+    }
   }
 };
-#define sim_port_construct(name) name(handle, #name)
+#define sim_port_construct(name) name(ports, #name)
+
+/**
+ * \brief port_view of a sim_port. It holds the same bytes as the Verilator
+ *port of that width (1, 2, 4 or 8 bytes up to 64 bits, 32 bit words above),
+ *so transaction words load and store the same on both simulators. XSI keeps
+ *the value as aVal/bVal pairs, so this is a copy through read_words() and
+ *write_words() rather than a memcpy, and there is no span().
+ **/
+template <int WIDTH, int DIR> class port_view<sim_port<WIDTH, DIR>> {
+  static constexpr std::size_t NWORDS = (WIDTH + 31) / 32;
+  sim_port<WIDTH, DIR> &m_port;
+
+  template <typename T> static constexpr void check() {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "transaction words are copied as bytes");
+    static_assert(sizeof(T) == bytes,
+                  "transaction word and port differ in size");
+  }
+
+public:
+  static constexpr std::size_t bytes =
+      WIDTH <= 64 ? sizeof(sim_port_value_t<WIDTH>) : NWORDS * 4;
+
+  explicit port_view(sim_port<WIDTH, DIR> &port) : m_port(port) {}
+  template <typename T> void load(const T &value) {
+    check<T>();
+    uint32_t words[NWORDS] = {};
+    memcpy(words, &value, bytes);
+    m_port.write_words(words);
+  }
+  template <typename T> void store(T &value) const {
+    check<T>();
+    uint32_t words[NWORDS];
+    m_port.read_words(words);
+    memcpy(&value, words, bytes);
+  }
+};
+
+/**
+ * \brief Read access to a toplevel port by name, as returned by
+ *xsim_driver::probe(). XSI has no access to signals below the toplevel, so
+ *this is the xsim counterpart of probe_ref for ports only. Every read is an
+ *xsi_get_value() of the kernel's value: writes to an input that are still
+ *deferred (see xsi_port_cache) are not seen before the next step.
+ **/
+template <typename T> class xsi_probe {
+  static_assert(std::is_integral_v<T> && sizeof(T) <= 8,
+                "xsi_probe reads ports of up to 64 bits");
+  xsiHandle m_handle;
+  int m_port;
+
+public:
+  using value_type = T;
+  xsi_probe(xsiHandle handle, int port) : m_handle(handle), m_port(port) {}
+  T operator*() const {
+    s_xsi_vlog_logicval words[2] = {};
+    xsi_get_value(m_handle, m_port, words);
+    return T(words[0].aVal | uint64_t(words[1].aVal) << 32);
+  }
+  operator T() const { return **this; }
+};
+
+template <typename dut_t>
+class xsim_driver : protected sim_driver<xsim_driver<dut_t>> {
+  using duration_t = ClockDriver::duration_t;
+  using base_t = sim_driver<xsim_driver>;
+  friend base_t;
+  using base_t::m_clocks;
+  using base_t::parse_cmd_line_args;
+  using base_t::restore_clocks;
+  using base_t::save_clocks;
+  using base_t::shutdown;
+  using base_t::sim_timeout;
+  using base_t::trace_depth;
+  using base_t::trace_scopes;
 
-template <typename dut_t> class xsim_driver : protected sim_driver {
   xsiHandle xsi_handle;
+  xsi_port_cache *m_ports;
+  duration_t m_now;
+
+  /// flush deferred port writes, advance the kernel and drop cached outputs
+  void run_kernel(duration_t ticks) {
+    m_ports->flush();
+    xsi_run(xsi_handle, ticks.count());
+    m_ports->invalidate();
+    m_now = duration_t(xsi_get_time(xsi_handle));
+  }
 
 protected:
   dut_t *dut;
-  /*set timout relative to NOW */
-  void set_sim_timeout(duration_t timeout) {
-    sim_timeout = get_now() + timeout;
+
+  /// XSI can only restart the simulation from time 0, see run_jobs()
+  static constexpr bool STATE_SNAPSHOT = false;
+  /// Remember the clocks for restore_state(), must be called at time 0
+  void save_state() {
+    except_assert2(get_now() == duration_t(0),
+                   "xsim can only restore the state at time 0");
+    save_clocks();
+  }
+  /// Restart the simulation from time 0, without reopening the design
+  void restore_state() {
+    xsi_restart(xsi_handle);
+    m_ports->restart();
+    m_now = duration_t(xsi_get_time(xsi_handle));
+    restore_clocks();
   }
+
+  /**
+   * \brief Read access to a toplevel port by name, e.g.
+   *probe<CData>("TOP.dc_fifo.wr_usedw") or probe<CData>("wr_usedw"). Names
+   *below the toplevel throw, since XSI only exposes the ports.
+   **/
+  template <typename T> xsi_probe<T> probe(const std::string &name) {
+    auto dot = name.rfind('.');
+    std::string scope = dot == std::string::npos ? "" : name.substr(0, dot);
+    if (scope.rfind("TOP.", 0) == 0)
+      scope.erase(0, 4);
+    except_assert2(scope.find('.') == std::string::npos,
+                   "xsim can only probe toplevel ports, not " + name);
+    std::string port_name = name.substr(dot + 1);
+    int port = xsi_get_port_number(xsi_handle, port_name.c_str());
+    except_assert2(port >= 0, "no port for probe " + name);
+    except_assert2(xsi_get_int_port(xsi_handle, port, xsiHDLValueSize) <=
+                       int(8 * sizeof(T)),
+                   "probe " + name + " is wider than the requested type");
+    return xsi_probe<T>(xsi_handle, port);
+  }
+
   xsim_driver(int argc, char **argv) {
     std::string waveform_file = parse_cmd_line_args(argc, argv);
     s_xsi_setup_info info = {0};
@@ -110,21 +376,29 @@ protected:
     std::filesystem::current_path(saved_cwd);
 
     if (waveform_file != "") {
+      // XSI can only trace the whole design
+      if (!trace_scopes.empty() || trace_depth) {
+        fprintf(stderr, "xsim_driver: trace_scope/trace_depth are not "
+                        "supported by XSI, tracing all signals\n");
+      }
       xsi_trace_all(xsi_handle);
     }
-    dut = new dut_t(xsi_handle);
+    m_now = duration_t(xsi_get_time(xsi_handle));
+    m_ports = new xsi_port_cache(xsi_handle);
+    dut = new dut_t(*m_ports);
 
     sim_timeout = std::chrono::milliseconds(10);
   }
   ~xsim_driver() {
     shutdown();
     delete dut;
+    delete m_ports;
+    xsi_close(xsi_handle);
   }
 
-  virtual duration_t get_now() final {
-    return duration_t(xsi_get_time(xsi_handle));
-  }
-  duration_t _update() final {
+  duration_t get_now() { return m_now; }
+  void start() {}
+  duration_t _update() {
     duration_t start = get_now();
     duration_t min_update = duration_t::max();
     for (auto &cd : m_clocks) {
@@ -132,7 +406,7 @@ protected:
       if (x < min_update)
         min_update = x;
     }
-    xsi_run(xsi_handle, (min_update - start).count());
+    run_kernel(min_update - start);
 
     duration_t now = get_now();
 
@@ -141,17 +415,13 @@ protected:
         cd.update(now);
       }
     }
-    xsi_run(xsi_handle, 0);
+    run_kernel(duration_t(0));
     for (auto &cd : m_clocks) {
       if (cd.last_update() == now) {
         cd.exec_callbacks();
       }
     }
 
-    if (sim_timeout != std::chrono::milliseconds(0) && now >= sim_timeout) {
-      throw std::runtime_error("Simulation timed out\n");
-    }
-
     return get_now() - start;
   }
 };
@@ -24,12 +24,16 @@ int main(int argc, char **argv) {
   for (int p = 0; p < num_ports; ++p) {
     const char *port_name = xsi_get_port_name(xsi_handle, p);
     int width = xsi_get_int_port(xsi_handle, p, xsiHDLValueSize);
-    fprintf(outf, "\tsim_port<%d> %s;\n", width, port_name);
+    int dir = xsi_get_int_port(xsi_handle, p, xsiDirectionTopPort);
+    const char *dir_name = dir == xsiInputPort    ? "xsiInputPort"
+                           : dir == xsiOutputPort ? "xsiOutputPort"
+                                                  : "xsiInoutPort";
+    fprintf(outf, "\tsim_port<%d, %s> %s;\n", width, dir_name, port_name);
   }
-  fprintf(outf, "\t%s(xsiHandle handle):\n", struct_typename);
+  fprintf(outf, "\t%s(xsi_port_cache &ports):\n", struct_typename);
   for (int p = 0; p < num_ports; ++p) {
     const char *port_name = xsi_get_port_name(xsi_handle, p);
-    fprintf(outf, "\t\t%s(handle,\"%s\")", port_name, port_name);
+    fprintf(outf, "\t\t%s(ports,\"%s\")", port_name, port_name);
     if (p != num_ports - 1) {
       fprintf(outf, ",");
     }
@@ -42,4 +46,6 @@ int main(int argc, char **argv) {
   fprintf(outf, "\t}\n");
   fprintf(outf, "};\n");
   fprintf(outf, "#endif\n");
+  fclose(outf);
+  xsi_close(xsi_handle);
 }
@@ -0,0 +1,587 @@
+#!/usr/bin/python3
+
+# Regression runner for the ctest tests of a build directory.
+#
+# Every test is split into shards, one per parameter set and, for tests
+# labelled "seeded" by create_test(SEEDED), one per seed. The shards are
+# served from a work queue on a socket to a pool of worker processes, one per
+# core by default. A worker runs one shard at a time in its own process, so a
+# crash or exit() only costs that shard. Shards that die from a signal, or
+# whose worker disappears, are retried. At the end one summary is printed:
+# pass/fail counts and run times per test, the command line of every failing
+# shard and the merged functional coverage (see cov_group::save()).
+#
+# Tests labelled "server" by create_test(SERVER) are built on
+# sim_driver::run_jobs(). Each worker starts them once as a warm server
+# (server=PATH) and sends every shard as a job, so the process start, model
+# construction and reset are paid once per worker instead of once per shard.
+# A server that dies is restarted for the next shard. --no-warm runs them like
+# any other test.
+#
+# Passing shards are remembered in a result cache (--cache-dir, by default
+# regress_cache in the build directory), keyed by a hash of the test binary,
+# the shared libraries it loads from the build tree, the elaborated xsim
+# design next to it and its arguments. A shard whose key has a cached pass is
+# not run again: after a change only the tests it affects re-simulate.
+# --force re-runs everything, --no-cache neither reads nor writes the cache.
+# With -DTEST_RESULT_CACHE=Y ctest runs each test through
+#     regress.py cached --build-dir DIR -- test args...
+# which uses the same scheme (REGRESS_FORCE=1 in the environment re-runs).
+#
+# Workers on other machines can join a run started with --listen by running
+#     regress.py worker --connect host:port --authkey KEY
+# with the build tree at the same path.
+#
+#     regress.py --build-dir build --seeds 1-100
+#     regress.py --build-dir build -R dc_fifo_lanes --params length=100 length=5000
+
+import argparse
+import hashlib
+import json
+import os
+import re
+import secrets
+import shlex
+import shutil
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from collections import deque
+from multiprocessing.connection import Client, Listener
+
+STATUSES = ["pass", "fail", "crash", "timeout"]
+
+
+def parse_seeds(text):
+    seeds = []
+    for item in text.split(","):
+        lo, _, hi = item.partition("-")
+        seeds += range(int(lo), int(hi or lo) + 1)
+    return seeds
+
+
+def parse_address(text):
+    host, _, port = text.rpartition(":")
+    if not host:
+        return text  # unix socket path
+    return (host, int(port))
+
+
+def discover(build_dir, regex, exclude):
+    cmd = ["ctest", "--test-dir", build_dir, "--show-only=json-v1"]
+    if regex:
+        cmd += ["-R", regex]
+    if exclude:
+        cmd += ["-E", exclude]
+    info = json.loads(subprocess.run(cmd, check=True, capture_output=True,
+                                     text=True).stdout)
+    tests = []
+    for t in info["tests"]:
+        props = {p["name"]: p["value"] for p in t.get("properties", [])}
+        command = t["command"]
+        if (len(command) > 2 and os.path.basename(command[1]) == "regress.py"
+                and command[2] == "cached"):
+            # ctest's result cache launcher, see cached_main()
+            command = command[command.index("--") + 1:]
+        tests.append({
+            "name": t["name"],
+            "command": command,
+            "cwd": props.get("WORKING_DIRECTORY", build_dir),
+            "seeded": "seeded" in props.get("LABELS", []),
+            "server": "server" in props.get("LABELS", []),
+        })
+    return tests
+
+
+def make_shards(tests, seeds, params, timeout, warm):
+    shards = []
+    for t in tests:
+        for p in params:
+            for seed in (seeds if t["seeded"] else [None]):
+                args = p.split()
+                if seed is not None:
+                    args.append(f"seed={seed}")
+                shards.append({
+                    "id": len(shards),
+                    "test": t["name"],
+                    "command": t["command"] + args,
+                    "base": t["command"],
+                    "args": args,
+                    "warm": warm and t["server"],
+                    "cwd": t["cwd"],
+                    "timeout": timeout,
+                })
+    return shards
+
+
+def run_shard(shard, cov_file):
+    start = time.monotonic()
+    cmd = shard["command"] + [f"coverage_file={cov_file}"]
+    try:
+        p = subprocess.run(cmd, cwd=shard["cwd"], capture_output=True,
+                           text=True, errors="replace",
+                           timeout=shard["timeout"] or None)
+        rc, output = p.returncode, p.stdout + p.stderr
+        if rc < 0:
+            output += f"\nkilled by signal {-rc}"
+        status = "pass" if rc == 0 else "crash" if rc < 0 else "fail"
+    except subprocess.TimeoutExpired as e:
+        rc, status = None, "timeout"
+        output = (e.stdout or b"").decode(errors="replace")
+    coverage = ""
+    if os.path.exists(cov_file):
+        with open(cov_file) as f:
+            coverage = f.read()
+        os.remove(cov_file)
+    return {
+        "status": status,
+        "returncode": rc,
+        "seconds": time.monotonic() - start,
+        "output": "\n".join(output.splitlines()[-20:]),
+        "coverage": coverage,
+    }
+
+
+class result_cache:
+    """Pass results keyed by a hash of everything a test run depends on. One
+    file per key, written atomically, so concurrent runs can share the
+    directory. Delete it to drop every entry."""
+
+    def __init__(self, path, build_dir):
+        self.path = path
+        self.build_dir = os.path.realpath(build_dir)
+        self.digests = {}
+        self.input_files = {}
+        os.makedirs(path, exist_ok=True)
+
+    def file_digest(self, path):
+        st = os.stat(path)
+        memo = (path, st.st_mtime_ns, st.st_size)
+        if memo not in self.digests:
+            h = hashlib.sha256()
+            with open(path, "rb") as f:
+                for chunk in iter(lambda: f.read(1 << 20), b""):
+                    h.update(chunk)
+            self.digests[memo] = h.hexdigest()
+        return self.digests[memo]
+
+    def inputs(self, binary, cwd):
+        """the binary, the libraries it links from the build tree and an
+        elaborated xsim design (xsim.dir) in its working directory"""
+        if (binary, cwd) in self.input_files:
+            return self.input_files[binary, cwd]
+        path = shutil.which(binary) or binary
+        files = [os.path.realpath(path)]
+        try:
+            ldd = subprocess.run(["ldd", path], capture_output=True,
+                                 text=True).stdout
+        except OSError:
+            ldd = ""
+        for lib in re.findall(r"=> (/\S+)", ldd):
+            lib = os.path.realpath(lib)
+            if lib.startswith(self.build_dir + os.sep):
+                files.append(lib)
+        for root, _, names in os.walk(os.path.join(cwd, "xsim.dir")):
+            files += [os.path.join(root, n) for n in names]
+        files = sorted(set(files))
+        self.input_files[binary, cwd] = files
+        return files
+
+    def key(self, command, cwd):
+        h = hashlib.sha256()
+        for f in self.inputs(command[0], cwd):
+            h.update(f"{f} {self.file_digest(f)}\n".encode())
+        h.update(json.dumps(command[1:]).encode())
+        return h.hexdigest()
+
+    def get(self, key):
+        try:
+            with open(os.path.join(self.path, key + ".json")) as f:
+                return json.load(f)
+        except (OSError, ValueError):
+            return None
+
+    def put(self, key, entry):
+        path = os.path.join(self.path, key + ".json")
+        with tempfile.NamedTemporaryFile("w", dir=self.path, delete=False,
+                                         suffix=".tmp") as f:
+            json.dump(entry, f)
+        os.replace(f.name, path)
+
+
+def cached_main(argv):
+    """ctest launcher: run the command after --, unless it passed before"""
+    ap = argparse.ArgumentParser(prog="regress.py cached")
+    ap.add_argument("cached")
+    ap.add_argument("--build-dir", required=True)
+    ap.add_argument("--force", action="store_true",
+                    default=os.environ.get("REGRESS_FORCE") == "1")
+    ap.add_argument("command", nargs="+")
+    args = ap.parse_args(argv)
+    cache = result_cache(os.path.join(args.build_dir, "regress_cache"),
+                         args.build_dir)
+    key = cache.key(args.command, os.getcwd())
+    entry = cache.get(key)
+    if entry and not args.force:
+        print(f"cached pass, {entry['seconds']:.2f} s when it ran, "
+              "REGRESS_FORCE=1 to run it again")
+        return 0
+    start = time.monotonic()
+    rc = subprocess.run(args.command).returncode
+    if rc == 0:
+        cache.put(key, {"seconds": time.monotonic() - start, "output": "",
+                        "coverage": ""})
+    if rc < 0:
+        # die the same way, so ctest reports the signal
+        signal.signal(-rc, signal.SIG_DFL)
+        os.kill(os.getpid(), -rc)
+    return rc
+
+
+class warm_server:
+    """One test binary running sim_driver::run_jobs() in server mode, fed one
+    job line per shard over its unix socket."""
+
+    def __init__(self, shard, tmp):
+        self.sock_path = os.path.join(tmp, f"{shard['test']}.sock")
+        self.log_path = os.path.join(tmp, f"{shard['test']}.log")
+        self.log = open(self.log_path, "w")
+        if os.path.exists(self.sock_path):
+            os.remove(self.sock_path)  # left by a server that crashed
+        self.proc = subprocess.Popen(
+            shard["base"] + [f"server={self.sock_path}"], cwd=shard["cwd"],
+            stdout=self.log, stderr=subprocess.STDOUT)
+        self.sock = None
+        while self.sock is None and self.proc.poll() is None:
+            try:
+                s = socket.socket(socket.AF_UNIX)
+                s.connect(self.sock_path)
+                self.sock = s
+            except OSError:
+                s.close()
+                time.sleep(0.05)
+        self.reader = self.sock.makefile("r") if self.sock else None
+
+    def run(self, shard, cov_file):
+        start = time.monotonic()
+        job = shard["args"] + [f"coverage_file={cov_file}"]
+        try:
+            if self.sock is None:
+                raise EOFError
+            self.sock.settimeout(shard["timeout"] or None)
+            self.sock.sendall((" ".join(job) + "\n").encode())
+            reply = self.reader.readline()
+            if not reply:
+                raise EOFError
+            status, _, rest = reply.strip().partition(" ")
+            _, _, message = rest.partition(" ")
+            status, rc = ("pass", 0) if status == "PASS" else ("fail", 1)
+        except (EOFError, OSError) as e:
+            timed_out = isinstance(e, socket.timeout)
+            # a server that hung up is given a moment to exit on its own
+            self.close(grace=0 if timed_out else 2)
+            status = "timeout" if timed_out else "crash"
+            rc = None if timed_out else self.proc.returncode
+            with open(self.log_path, errors="replace") as f:
+                message = f.read()
+            if rc is not None and rc < 0:
+                message += f"\nkilled by signal {-rc}"
+        coverage = ""
+        if os.path.exists(cov_file):
+            with open(cov_file) as f:
+                coverage = f.read()
+            os.remove(cov_file)
+        return {
+            "status": status,
+            "returncode": rc,
+            "seconds": time.monotonic() - start,
+            "output": "\n".join(message.splitlines()[-20:]),
+            "coverage": coverage,
+        }
+
+    def alive(self):
+        return self.sock is not None
+
+    def close(self, quit=False, grace=10):
+        if self.sock is not None:
+            if quit:
+                try:
+                    self.sock.sendall(b"quit\n")
+                except OSError:
+                    pass
+            self.reader.close()
+            self.sock.close()
+            self.sock = None
+        try:
+            self.proc.wait(timeout=grace)
+        except subprocess.TimeoutExpired:
+            self.proc.kill()
+            self.proc.wait()
+        self.log.close()
+
+
+def worker(address, authkey):
+    conn = Client(parse_address(address), authkey=authkey.encode())
+    servers = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        cov_file = os.path.join(tmp, "coverage.txt")
+        # every message asks for the next shard
+        msg = ("ready", None)
+        while True:
+            conn.send(msg)
+            shard = conn.recv()
+            if shard is None:
+                break
+            if not shard["warm"]:
+                msg = ("result", run_shard(shard, cov_file))
+                continue
+            server = servers.get(shard["test"])
+            if server is None or not server.alive():
+                server = servers[shard["test"]] = warm_server(shard, tmp)
+            msg = ("result", server.run(shard, cov_file))
+        for server in servers.values():
+            if server.alive():
+                server.close(quit=True)
+    conn.close()
+
+
+class work_queue:
+    """Hands shards to workers, one at a time, until every shard has a final
+    result. A shard whose run crashed, or whose worker went away, is put back
+    up to `retries` times."""
+
+    def __init__(self, shards, retries):
+        self.pending = deque(shards)
+        self.results = {}
+        self.attempts = {s["id"]: 0 for s in shards}
+        self.total = len(shards)
+        self.retries = retries
+        self.cond = threading.Condition()
+
+    def done(self):
+        return len(self.results) == self.total
+
+    def get(self):
+        with self.cond:
+            while not self.pending and not self.done():
+                self.cond.wait()
+            if self.done():
+                return None
+            shard = self.pending.popleft()
+            self.attempts[shard["id"]] += 1
+            return shard
+
+    def put(self, shard, result):
+        with self.cond:
+            if (result["status"] == "crash" and
+                    self.attempts[shard["id"]] <= self.retries):
+                last = (result["output"].splitlines() or [""])[-1]
+                print(f"retrying {shard['test']} shard {shard['id']}: {last}",
+                      flush=True)
+                self.pending.append(shard)
+            else:
+                result["attempts"] = self.attempts[shard["id"]]
+                self.results[shard["id"]] = result
+                if result["status"] != "pass":
+                    print(f"{result['status']}: {shard['test']} "
+                          f"{shlex.join(shard['command'][1:])}", flush=True)
+            self.cond.notify_all()
+
+    def serve(self, conn):
+        shard = None
+        try:
+            while True:
+                msg, result = conn.recv()
+                if msg == "result":
+                    self.put(shard, result)
+                shard = self.get()
+                conn.send(shard)
+                if shard is None:
+                    break
+        except (EOFError, ConnectionError):
+            if shard is not None:
+                self.put(shard, {"status": "crash", "returncode": None,
+                                 "seconds": 0, "output": "worker lost",
+                                 "coverage": ""})
+        finally:
+            conn.close()
+
+
+def merge_coverage(results):
+    """sum the `group point bin count goal` lines of every shard"""
+    bins = {}
+    for r in results:
+        for line in r["coverage"].splitlines():
+            group, point, b, count, goal = line.split()
+            key = (group, point, int(b))
+            c, g = bins.get(key, (0, 0))
+            bins[key] = (c + int(count), max(g, int(goal)))
+    return bins
+
+
+def summary(shards, results, wall, bins, out):
+    by_test = {}
+    for s in shards:
+        by_test.setdefault(s["test"], []).append(results[s["id"]])
+    print(f"\n{'test':32} {'pass':>6} {'fail':>6} {'crash':>6} {'timeout':>8}"
+          f" {'total s':>9} {'max s':>7}", file=out)
+    for name, rs in by_test.items():
+        n = {st: sum(r["status"] == st for r in rs) for st in STATUSES}
+        secs = [r["seconds"] for r in rs]
+        print(f"{name:32} {n['pass']:6} {n['fail']:6} {n['crash']:6} "
+              f"{n['timeout']:8} {sum(secs):9.2f} {max(secs):7.2f}", file=out)
+
+    failed = [s for s in shards if results[s["id"]]["status"] != "pass"]
+    for s in failed:
+        r = results[s["id"]]
+        print(f"\n{r['status']} after {r['attempts']} attempt(s): "
+              f"(cd {shlex.quote(s['cwd'])} && {shlex.join(s['command'])})",
+              file=out)
+        for line in r["output"].splitlines():
+            print(f"    {line}", file=out)
+
+    groups = {}
+    for (group, _, _), (count, goal) in bins.items():
+        total, met = groups.get(group, (0, 0))
+        if goal:
+            groups[group] = (total + 1, met + (count >= goal))
+    for group, (total, met) in groups.items():
+        print(f"\ncoverage {group}: {met}/{total} goals met", file=out)
+
+    cpu = sum(r["seconds"] for r in results.values())
+    cached = sum(r.get("cached", False) for r in results.values())
+    print(f"\n{len(shards) - len(failed)}/{len(shards)} shards passed "
+          f"({cached} from the cache), {wall:.1f} s wall, {cpu:.1f} s summed "
+          "over shards", file=out)
+    return not failed
+
+
+def main():
+    if len(sys.argv) > 1 and sys.argv[1] == "worker":
+        ap = argparse.ArgumentParser(prog="regress.py worker")
+        ap.add_argument("worker")
+        ap.add_argument("--connect", required=True, help="host:port or path")
+        ap.add_argument("--authkey", required=True)
+        args = ap.parse_args()
+        worker(args.connect, args.authkey)
+        return 0
+    if len(sys.argv) > 1 and sys.argv[1] == "cached":
+        return cached_main(sys.argv[1:])
+
+    ap = argparse.ArgumentParser(description="Sharded regression runner")
+    ap.add_argument("--build-dir", default=".")
+    ap.add_argument("-R", "--tests", help="only tests matching this regex")
+    ap.add_argument("-E", "--exclude", help="skip tests matching this regex")
+    ap.add_argument("--seeds", default="1",
+                    help="seeds for seeded tests, e.g. 1-100,200")
+    ap.add_argument("--params", nargs="+", default=[""],
+                    help="extra key=value argument sets, one shard each")
+    ap.add_argument("-j", "--jobs", type=int, default=os.cpu_count(),
+                    help="local workers, 0 to only serve remote workers")
+    ap.add_argument("--retries", type=int, default=1,
+                    help="reruns of a shard that crashed")
+    ap.add_argument("--timeout", type=float, default=0,
+                    help="kill a shard after this many seconds")
+    ap.add_argument("--listen", help="serve the queue on host:port, so "
+                    "workers on other machines can join")
+    ap.add_argument("--authkey", default=secrets.token_hex(16))
+    ap.add_argument("--no-warm", action="store_true",
+                    help="start a fresh process for every shard, also of "
+                    "tests labelled server")
+    ap.add_argument("--cache-dir", help="result cache, default "
+                    "regress_cache in the build directory")
+    ap.add_argument("--force", action="store_true",
+                    help="run every shard, also those with a cached pass")
+    ap.add_argument("--no-cache", action="store_true",
+                    help="do not read or write the result cache")
+    ap.add_argument("--coverage-out", help="write the merged coverage here")
+    ap.add_argument("--json", help="write every shard result here")
+    args = ap.parse_args()
+
+    build_dir = os.path.abspath(args.build_dir)
+    tests = discover(build_dir, args.tests, args.exclude)
+    if not tests:
+        sys.exit("no tests found")
+    shards = make_shards(tests, parse_seeds(args.seeds), args.params,
+                         args.timeout, not args.no_warm)
+
+    cache, keys, cached = None, {}, {}
+    if not args.no_cache:
+        cache = result_cache(args.cache_dir or
+                             os.path.join(build_dir, "regress_cache"),
+                             build_dir)
+        for s in shards:
+            # every shard runs with a coverage_file, see run_shard()
+            keys[s["id"]] = cache.key(s["command"] + ["coverage_file"],
+                                      s["cwd"])
+            entry = None if args.force else cache.get(keys[s["id"]])
+            if entry:
+                cached[s["id"]] = dict(entry, status="pass", returncode=0,
+                                       seconds=0, attempts=0, cached=True)
+    queue = work_queue([s for s in shards if s["id"] not in cached],
+                       args.retries)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        address = (parse_address(args.listen) if args.listen else
+                   os.path.join(tmp, "queue"))
+        listener = Listener(address, authkey=args.authkey.encode())
+        connect = address
+        if args.listen:
+            connect = "%s:%d" % listener.address
+            print(f"queue on {connect}, authkey {args.authkey}", flush=True)
+
+        def accept():
+            while True:
+                try:
+                    conn = listener.accept()
+                except OSError:
+                    return
+                threading.Thread(target=queue.serve, args=(conn,),
+                                 daemon=True).start()
+
+        threading.Thread(target=accept, daemon=True).start()
+        def spawn():
+            return subprocess.Popen([sys.executable, __file__, "worker",
+                                     "--connect", connect, "--authkey",
+                                     args.authkey])
+
+        start = time.monotonic()
+        workers = [spawn() for _ in range(args.jobs)]
+        with queue.cond:
+            while not queue.done():
+                queue.cond.wait(1)
+                # replace local workers that died, their shard is requeued
+                for i, w in enumerate(workers):
+                    if w.poll() is not None and not queue.done():
+                        workers[i] = spawn()
+        wall = time.monotonic() - start
+        for w in workers:
+            w.wait()
+        listener.close()
+
+    results = {**queue.results, **cached}
+    if cache:
+        for s in shards:
+            r = queue.results.get(s["id"])
+            if r and r["status"] == "pass":
+                cache.put(keys[s["id"]], {"seconds": r["seconds"],
+                                          "output": r["output"],
+                                          "coverage": r["coverage"]})
+    bins = merge_coverage(results.values())
+    if args.coverage_out:
+        with open(args.coverage_out, "w") as f:
+            for (group, point, b), (count, goal) in sorted(bins.items()):
+                f.write(f"{group} {point} {b} {count} {goal}\n")
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump([dict(s, **results[s["id"]]) for s in shards], f,
+                      indent=1)
+    return 0 if summary(shards, results, wall, bins, sys.stdout) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())